@@ -0,0 +1,238 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2018 George Cave <gcave@stablecoder.ca>
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ */
+
+#include "cmkizer.hpp"
+#include "parallel.hpp"
+#include "scan.hpp"
+#include "util.hpp"
+#include "verify.hpp"
+
+// libxml
+#include <libxml/parser.h>
+
+// C++
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <mutex>
+#include <unordered_set>
+
+namespace {
+
+/// The output of converting a single input of a directory scan.
+struct ConversionResult {
+    bool success{false};
+    GeneratedFiles files;
+    std::vector<std::string> diagnostics;
+};
+
+/// Normalizes a path for comparison, project files come from case-insensitive
+/// filesystems.
+std::string comparablePath(std::string_view path) {
+    std::string retVal = std::filesystem::path(path).lexically_normal().generic_string();
+    std::transform(retVal.begin(), retVal.end(), retVal.begin(), ::tolower);
+    return retVal;
+}
+
+/// Generates the files for a prepared project with the chosen backend.
+void generateProject(ProjectData &data,
+                     GlobalSettings const &globalSettings,
+                     GeneratedFiles &files) {
+    if (globalSettings.backend == 1) {
+        generateNinjaProject(data, globalSettings, files, data.diagnostics);
+    } else {
+        generateCMakeProject(data, globalSettings, files);
+    }
+}
+
+} // namespace
+
+void initializeCmkizer() {
+    static std::once_flag initFlag;
+    std::call_once(initFlag, []() { xmlInitParser(); });
+}
+
+ProjectData prepareProject(ProjectData data, GlobalSettings const &globalSettings) {
+    data = projectPreprocessing(std::move(data));
+    if (globalSettings.inferIncludes) {
+        inferIncludeDirs(data);
+    }
+    if (globalSettings.inferPch != 0) {
+        inferPrecompiledHeaders(data, globalSettings.inferPch == 2);
+    }
+    if (globalSettings.verifySources != 0) {
+        verifySources(data, globalSettings.verifySources == 2);
+    }
+    if (globalSettings.shareSources) {
+        shareCommonSources(data);
+    }
+    if (globalSettings.unityBuild) {
+        assignUnityGroups(data);
+    }
+    return data;
+}
+
+bool convertProject(std::string_view path,
+                    GlobalSettings const &globalSettings,
+                    GeneratedFiles &files,
+                    std::vector<std::string> &diagnostics) {
+    auto [found, contents] = readFile(std::string{path});
+    if (!found) {
+        diagnostics.emplace_back("Error: Could not read file - " + std::string{path});
+        return false;
+    }
+
+    return convertProject(path, contents, readFile, globalSettings, files, diagnostics);
+}
+
+bool convertProject(std::string_view path,
+                    std::string_view contents,
+                    FileReader const &readFile,
+                    GlobalSettings const &globalSettings,
+                    GeneratedFiles &files,
+                    std::vector<std::string> &diagnostics) {
+    initializeCmkizer();
+
+    auto [projSuccess, projData] =
+        parseProject(path, contents, readFile, {}, globalSettings.selectedTargets);
+    if (projSuccess) {
+        projData = prepareProject(std::move(projData), globalSettings);
+        generateProject(projData, globalSettings, files);
+        diagnostics.insert(diagnostics.end(), projData.diagnostics.begin(),
+                           projData.diagnostics.end());
+        return true;
+    }
+
+    auto [targetSuccess, targetData] = parseTarget(path, contents, readFile);
+    if (targetSuccess) {
+        ProjectData temp;
+        temp.targets.emplace_back(std::move(targetData));
+        temp = prepareProject(std::move(temp), globalSettings);
+        if (globalSettings.backend == 1) {
+            // The build.ninja goes beside the project file itself.
+            temp.path = path;
+            generateNinjaProject(temp, globalSettings, files, temp.diagnostics);
+        } else {
+            generateCMakeTarget(temp.targets[0], globalSettings, files);
+        }
+        diagnostics.insert(diagnostics.end(), temp.diagnostics.begin(),
+                           temp.diagnostics.end());
+        return true;
+    }
+
+    diagnostics.emplace_back("Error: Could not parse file - " + std::string{path});
+    return false;
+}
+
+void mergeGeneratedFiles(GeneratedFiles &files,
+                         GeneratedFiles &inputFiles,
+                         std::string const &input,
+                         std::vector<std::string> &diagnostics) {
+    for (auto &[path, contents] : inputFiles) {
+        auto [it, inserted] = files.try_emplace(path, std::move(contents));
+        if (!inserted && it->second != contents) {
+            diagnostics.emplace_back("Warning: " + path + " is also generated by " + input +
+                                     ", keeping the first");
+        }
+    }
+}
+
+bool convertDirectory(std::string_view rootDir,
+                      GlobalSettings const &globalSettings,
+                      GeneratedFiles &files,
+                      std::vector<std::string> &diagnostics,
+                      unsigned threadCount) {
+    initializeCmkizer();
+
+    ScanResult scan = scanDirectory(rootDir, threadCount);
+
+    // Solutions first, to learn which project files are referenced.
+    std::vector<ConversionResult> solutionResults(scan.solutions.size());
+    std::vector<std::vector<std::string>> referencedTargets(scan.solutions.size());
+    parallelFor(scan.solutions.size(), threadCount, [&](std::size_t idx) {
+        auto &result = solutionResults[idx];
+
+        auto [projSuccess, projData] =
+            parseProject(scan.solutions[idx], {}, globalSettings.selectedTargets);
+        if (!projSuccess) {
+            result.diagnostics.emplace_back("Error: Could not parse file - " +
+                                            scan.solutions[idx]);
+            return;
+        }
+        for (auto const &target : projData.targets) {
+            referencedTargets[idx].emplace_back(comparablePath(target.fullPath));
+        }
+
+        projData = prepareProject(std::move(projData), globalSettings);
+        generateProject(projData, globalSettings, result.files);
+        result.diagnostics = std::move(projData.diagnostics);
+        result.success = true;
+    });
+
+    std::unordered_set<std::string> referenced;
+    for (auto const &paths : referencedTargets) {
+        referenced.insert(paths.begin(), paths.end());
+    }
+    // With a selection, standalone project files are matched by file name.
+    std::unordered_set<std::string> selectedNames;
+    for (auto const &name : globalSettings.selectedTargets) {
+        selectedNames.emplace(comparablePath(name));
+    }
+    std::vector<std::string> standaloneTargets;
+    for (auto const &target : scan.targets) {
+        if (referenced.count(comparablePath(target)) != 0) {
+            continue;
+        }
+        if (selectedNames.empty() ||
+            selectedNames.count(comparablePath(std::filesystem::path(target).stem().string())) !=
+                0) {
+            standaloneTargets.emplace_back(target);
+        }
+    }
+
+    std::vector<ConversionResult> targetResults(standaloneTargets.size());
+    parallelFor(standaloneTargets.size(), threadCount, [&](std::size_t idx) {
+        auto &result = targetResults[idx];
+        result.success = convertProject(standaloneTargets[idx], globalSettings, result.files,
+                                        result.diagnostics);
+    });
+
+    // Merged in input order, so the output does not depend on thread timing.
+    bool success = true;
+    auto merge = [&](ConversionResult &result, std::string const &input) {
+        success = success && result.success;
+        diagnostics.insert(diagnostics.end(), std::make_move_iterator(result.diagnostics.begin()),
+                           std::make_move_iterator(result.diagnostics.end()));
+        mergeGeneratedFiles(files, result.files, input, diagnostics);
+    };
+    for (std::size_t idx = 0; idx < solutionResults.size(); ++idx) {
+        merge(solutionResults[idx], scan.solutions[idx]);
+    }
+    for (std::size_t idx = 0; idx < targetResults.size(); ++idx) {
+        merge(targetResults[idx], standaloneTargets[idx]);
+    }
+
+    return success;
+}
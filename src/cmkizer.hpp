@@ -0,0 +1,120 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2018 George Cave <gcave@stablecoder.ca>
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ */
+
+#ifndef CMKIZER_HPP
+#define CMKIZER_HPP
+
+// Public interface of the cmkizer library. None of these functions use any
+// global state or print anything, so separate conversions may run on different
+// threads at the same time. Even the directories of the listed files are kept
+// per project, in the ProjectData's own PathTable.
+
+#include "file_parser.hpp"
+#include "generators.hpp"
+#include "include_scan.hpp"
+#include "ninja.hpp"
+#include "pipeline.hpp"
+#include "shared_sources.hpp"
+#include "type_defs.hpp"
+#include "unity.hpp"
+#include "verify.hpp"
+
+// C++
+#include <string>
+#include <string_view>
+#include <vector>
+
+/// Prepares the XML parser for use. Called implicitly by convertProject, but
+/// must be called before using the individual parse functions from multiple
+/// threads.
+void initializeCmkizer();
+
+/// Preprocesses a parsed project, then infers include directories and
+/// precompiled headers, checks its sources, compiles shared sources once and
+/// groups sources for a unity build, as the settings ask. Every conversion, and
+/// a model snapshot, prepares a project this way before generating from it.
+/// \param data The parsed project.
+/// \param globalSettings The settings to prepare with.
+/// \return The prepared project.
+ProjectData prepareProject(ProjectData data, GlobalSettings const &globalSettings);
+
+/// Parses, preprocesses and generates the CMake files for a solution/workspace,
+/// or for a standalone project file.
+/// \param path The path to the solution, workspace or project file.
+/// \param globalSettings The settings to generate with.
+/// \param files Receives the generated files, keyed by their output path.
+/// \param diagnostics Receives any errors or warnings encountered.
+/// \return True if the file could be parsed and CMake was generated.
+bool convertProject(std::string_view path,
+                    GlobalSettings const &globalSettings,
+                    GeneratedFiles &files,
+                    std::vector<std::string> &diagnostics);
+
+/// Parses, preprocesses and generates the CMake files for a solution/workspace
+/// or standalone project file already held in memory.
+/// \param path The path of the file, its extension determines the type and
+/// referenced files and generated output are relative to it.
+/// \param contents The contents of the file.
+/// \param readFile Provides the contents of referenced files.
+/// \param globalSettings The settings to generate with.
+/// \param files Receives the generated files, keyed by their output path.
+/// \param diagnostics Receives any errors or warnings encountered.
+/// \return True if the file could be parsed and CMake was generated.
+bool convertProject(std::string_view path,
+                    std::string_view contents,
+                    FileReader const &readFile,
+                    GlobalSettings const &globalSettings,
+                    GeneratedFiles &files,
+                    std::vector<std::string> &diagnostics);
+
+/// Merges the files generated for one input into those of the inputs before
+/// it. If a file was already generated with other contents, the first is
+/// kept and a warning given.
+/// \param files The files generated so far.
+/// \param inputFiles The files generated for the input, moved from.
+/// \param input The input they were generated for.
+/// \param diagnostics Receives a warning for each conflicting file.
+void mergeGeneratedFiles(GeneratedFiles &files,
+                         GeneratedFiles &inputFiles,
+                         std::string const &input,
+                         std::vector<std::string> &diagnostics);
+
+/// Converts every solution/workspace found beneath a directory, along with
+/// every project file that none of them reference. Inputs are converted in
+/// parallel, and if several generate the same file the first in path order is
+/// kept.
+/// \param rootDir The directory to search.
+/// \param globalSettings The settings to generate with.
+/// \param files Receives the generated files, keyed by their output path.
+/// \param diagnostics Receives any errors or warnings encountered.
+/// \param threadCount The number of threads to use, 0 for the hardware concurrency.
+/// \return True if every input found was converted.
+bool convertDirectory(std::string_view rootDir,
+                      GlobalSettings const &globalSettings,
+                      GeneratedFiles &files,
+                      std::vector<std::string> &diagnostics,
+                      unsigned threadCount = 0);
+
+#endif // CMKIZER_HPP
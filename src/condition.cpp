@@ -0,0 +1,320 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2018 George Cave <gcave@stablecoder.ca>
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ */
+
+#include "condition.hpp"
+
+// C++
+#include <algorithm>
+#include <cctype>
+
+namespace {
+
+bool iequals(std::string_view lhs, std::string_view rhs) noexcept {
+    return lhs.size() == rhs.size() &&
+           std::equal(lhs.begin(), lhs.end(), rhs.begin(), [](unsigned char a, unsigned char b) {
+               return std::tolower(a) == std::tolower(b);
+           });
+}
+
+/// Splits text into alternating literal and property name segments.
+std::vector<std::string> splitSegments(std::string_view text) {
+    std::vector<std::string> segments;
+
+    std::size_t start = 0;
+    auto propStart = text.find("$(");
+    while (propStart != std::string_view::npos) {
+        auto propEnd = text.find(')', propStart);
+        if (propEnd == std::string_view::npos) {
+            break;
+        }
+        segments.emplace_back(text.substr(start, propStart - start));
+        segments.emplace_back(text.substr(propStart + 2, propEnd - propStart - 2));
+
+        start = propEnd + 1;
+        propStart = text.find("$(", start);
+    }
+    segments.emplace_back(text.substr(start));
+
+    return segments;
+}
+
+/// Recursive descent parser over the MSBuild condition grammar:
+///   or     := and ('or' and)*
+///   and    := unary ('and' unary)*
+///   unary  := '!' unary | '(' or ')' | operand (('==' | '!=') operand)?
+///   operand:= 'quoted' | $(Property) | word | Function(...)
+struct Parser {
+    std::string_view text;
+    std::size_t pos{0};
+    Condition &out;
+    bool failed{false};
+
+    void skipSpace() noexcept {
+        while (pos < text.size() && std::isspace(static_cast<unsigned char>(text[pos]))) {
+            ++pos;
+        }
+    }
+
+    bool consume(std::string_view token) noexcept {
+        skipSpace();
+        if (text.substr(pos, token.size()) == token) {
+            pos += token.size();
+            return true;
+        }
+        return false;
+    }
+
+    bool consumeKeyword(std::string_view keyword) noexcept {
+        skipSpace();
+        auto end = pos + keyword.size();
+        if (iequals(text.substr(pos, keyword.size()), keyword) &&
+            (end == text.size() || !std::isalnum(static_cast<unsigned char>(text[end])))) {
+            pos = end;
+            return true;
+        }
+        return false;
+    }
+
+    int addNode(ConditionNode::Type type, int lhs = -1, int rhs = -1) {
+        out.nodes.push_back(ConditionNode{type, lhs, rhs, {}});
+        return static_cast<int>(out.nodes.size() - 1);
+    }
+
+    int fail() noexcept {
+        failed = true;
+        return -1;
+    }
+
+    int parseOr() {
+        int lhs = parseAnd();
+        while (!failed && consumeKeyword("or")) {
+            lhs = addNode(ConditionNode::Type::Or, lhs, parseAnd());
+        }
+        return lhs;
+    }
+
+    int parseAnd() {
+        int lhs = parseUnary();
+        while (!failed && consumeKeyword("and")) {
+            lhs = addNode(ConditionNode::Type::And, lhs, parseUnary());
+        }
+        return lhs;
+    }
+
+    int parseUnary() {
+        if (consume("!=")) {
+            return fail();
+        }
+        if (consume("!")) {
+            return addNode(ConditionNode::Type::Not, parseUnary());
+        }
+        if (consume("(")) {
+            int inner = parseOr();
+            if (!consume(")")) {
+                return fail();
+            }
+            return inner;
+        }
+
+        int lhs = parseOperand();
+        if (consume("==")) {
+            return addNode(ConditionNode::Type::Equal, lhs, parseOperand());
+        }
+        if (consume("!=")) {
+            return addNode(ConditionNode::Type::NotEqual, lhs, parseOperand());
+        }
+        return lhs;
+    }
+
+    int parseOperand() {
+        skipSpace();
+        if (pos >= text.size()) {
+            return fail();
+        }
+
+        std::size_t start = pos;
+        if (text[pos] == '\'') {
+            auto end = text.find('\'', pos + 1);
+            if (end == std::string_view::npos) {
+                return fail();
+            }
+            pos = end + 1;
+            int node = addNode(ConditionNode::Type::Value);
+            out.nodes[node].segments = splitSegments(text.substr(start + 1, end - start - 1));
+            return node;
+        }
+        if (text.substr(pos, 2) == "$(") {
+            auto end = text.find(')', pos);
+            if (end == std::string_view::npos) {
+                return fail();
+            }
+            pos = end + 1;
+            int node = addNode(ConditionNode::Type::Value);
+            out.nodes[node].segments = splitSegments(text.substr(start, pos - start));
+            return node;
+        }
+
+        while (pos < text.size() && (std::isalnum(static_cast<unsigned char>(text[pos])) ||
+                                     text[pos] == '_' || text[pos] == '.')) {
+            ++pos;
+        }
+        if (pos == start) {
+            return fail();
+        }
+
+        if (pos < text.size() && text[pos] == '(') {
+            // Function call, skip over the arguments, respecting quotes.
+            int depth = 0;
+            bool quoted = false;
+            for (; pos < text.size(); ++pos) {
+                if (text[pos] == '\'') {
+                    quoted = !quoted;
+                } else if (!quoted && text[pos] == '(') {
+                    ++depth;
+                } else if (!quoted && text[pos] == ')' && --depth == 0) {
+                    break;
+                }
+            }
+            if (pos == text.size()) {
+                return fail();
+            }
+            ++pos;
+            int node = addNode(ConditionNode::Type::Function);
+            out.nodes[node].segments.emplace_back(text.substr(start, pos - start));
+            return node;
+        }
+
+        int node = addNode(ConditionNode::Type::Value);
+        out.nodes[node].segments.emplace_back(text.substr(start, pos - start));
+        return node;
+    }
+};
+
+std::string expandValue(Condition const &condition, int index, PropertyMap const &properties) {
+    auto const &node = condition.nodes[index];
+    if (node.type != ConditionNode::Type::Value) {
+        return {};
+    }
+
+    std::string value;
+    for (std::size_t i = 0; i < node.segments.size(); ++i) {
+        if (i % 2 == 0) {
+            value += node.segments[i];
+            continue;
+        }
+        // MSBuild property names are case-insensitive.
+        for (auto const &[name, propValue] : properties) {
+            if (iequals(name, node.segments[i])) {
+                value += propValue;
+                break;
+            }
+        }
+    }
+
+    return value;
+}
+
+bool evaluateNode(Condition const &condition, int index, PropertyMap const &properties) {
+    auto const &node = condition.nodes[index];
+
+    switch (node.type) {
+    case ConditionNode::Type::Or:
+        return evaluateNode(condition, node.lhs, properties) ||
+               evaluateNode(condition, node.rhs, properties);
+    case ConditionNode::Type::And:
+        return evaluateNode(condition, node.lhs, properties) &&
+               evaluateNode(condition, node.rhs, properties);
+    case ConditionNode::Type::Not:
+        return !evaluateNode(condition, node.lhs, properties);
+    case ConditionNode::Type::Equal:
+        return iequals(expandValue(condition, node.lhs, properties),
+                       expandValue(condition, node.rhs, properties));
+    case ConditionNode::Type::NotEqual:
+        return !iequals(expandValue(condition, node.lhs, properties),
+                        expandValue(condition, node.rhs, properties));
+    case ConditionNode::Type::Value:
+        return iequals(expandValue(condition, index, properties), "true");
+    case ConditionNode::Type::Function:
+        // Functions such as Exists() depend on the build environment.
+        return false;
+    }
+
+    return false;
+}
+
+} // namespace
+
+std::tuple<bool, Condition> compileCondition(std::string_view expression) {
+    Condition condition;
+    Parser parser{expression, 0, condition};
+
+    parser.skipSpace();
+    if (parser.pos == expression.size()) {
+        // An empty condition is always true.
+        return std::make_tuple(true, condition);
+    }
+
+    condition.root = parser.parseOr();
+    parser.skipSpace();
+    if (parser.failed || parser.pos != expression.size()) {
+        return std::make_tuple(false, Condition());
+    }
+
+    return std::make_tuple(true, condition);
+}
+
+bool evaluateCondition(Condition const &condition, PropertyMap const &properties) {
+    if (condition.root == -1) {
+        return true;
+    }
+    return evaluateNode(condition, condition.root, properties);
+}
+
+ConditionCache::ConditionCache(std::vector<std::string> configNames,
+                               std::vector<PropertyMap> configProperties) :
+    configNames(std::move(configNames)),
+    configProperties(std::move(configProperties)) {}
+
+std::vector<bool> const &ConditionCache::evaluate(std::string_view expression) {
+    auto it = entries.find(expression);
+    if (it != entries.end()) {
+        return it->second.matches;
+    }
+
+    auto [success, condition] = compileCondition(expression);
+
+    Entry entry;
+    entry.matches.reserve(configNames.size());
+    for (std::size_t i = 0; i < configNames.size(); ++i) {
+        if (success) {
+            entry.matches.push_back(evaluateCondition(condition, configProperties[i]));
+        } else {
+            entry.matches.push_back(expression.find(configNames[i]) != std::string_view::npos);
+        }
+    }
+    entry.condition = std::move(condition);
+
+    return entries.emplace(std::string(expression), std::move(entry)).first->second.matches;
+}
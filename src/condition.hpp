@@ -0,0 +1,114 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2018 George Cave <gcave@stablecoder.ca>
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ */
+
+#ifndef CONDITION_HPP
+#define CONDITION_HPP
+
+// C++
+#include <functional>
+#include <map>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+
+/// A set of MSBuild properties, such as 'Configuration' and 'Platform', that
+/// property references within a condition are expanded against.
+using PropertyMap = std::map<std::string, std::string>;
+
+/// A single node of a compiled MSBuild condition expression.
+struct ConditionNode {
+    enum class Type {
+        Or,
+        And,
+        Not,
+        Equal,
+        NotEqual,
+        /// A string, possibly with $(Property) references, used as a value
+        Value,
+        /// A function call such as Exists(), which is not evaluated
+        Function,
+    };
+
+    Type type;
+    /// Index of the left/only operand node, or -1
+    int lhs{-1};
+    /// Index of the right operand node, or -1
+    int rhs{-1};
+    /// For values, alternating segments of literal text (even indices) and
+    /// property names (odd indices).
+    std::vector<std::string> segments;
+};
+
+/// A compiled MSBuild condition expression, such as
+/// "'$(Configuration)|$(Platform)'=='Release|x64'".
+struct Condition {
+    /// Flattened expression tree, operands are referenced by index
+    std::vector<ConditionNode> nodes;
+    /// Index of the root node, or -1 for an empty (always true) condition
+    int root{-1};
+};
+
+/// Compiles an MSBuild condition expression.
+/// \param expression The condition text to compile.
+/// \return A boolean representing the compile success, and the compiled Condition.
+std::tuple<bool, Condition> compileCondition(std::string_view expression);
+
+/// Evaluates a compiled condition against a set of properties.
+/// \param condition The compiled condition to evaluate.
+/// \param properties The properties that $(Property) references expand to.
+/// \return True if the condition holds for the given properties.
+bool evaluateCondition(Condition const &condition, PropertyMap const &properties);
+
+/// Compiles and evaluates conditions against a fixed set of configurations.
+///
+/// Each distinct condition string is compiled and evaluated once per
+/// configuration, repeated lookups of the same string are served from the
+/// cache.
+class ConditionCache {
+  public:
+    /// \param configNames The configuration names, such as 'Debug|Win32'.
+    /// \param configProperties The properties for each configuration, in the
+    /// same order as configNames.
+    ConditionCache(std::vector<std::string> configNames, std::vector<PropertyMap> configProperties);
+
+    /// Returns, for each configuration, whether the condition holds for it.
+    /// Conditions that fail to compile fall back to matching any configuration
+    /// whose name appears within the condition text.
+    /// \param expression The condition text.
+    std::vector<bool> const &evaluate(std::string_view expression);
+
+  private:
+    struct Entry {
+        Condition condition;
+        std::vector<bool> matches;
+    };
+
+    std::vector<std::string> configNames;
+    std::vector<PropertyMap> configProperties;
+    std::map<std::string, Entry, std::less<>> entries;
+};
+
+#endif // CONDITION_HPP
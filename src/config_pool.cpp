@@ -0,0 +1,102 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2018 George Cave <gcave@stablecoder.ca>
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ */
+
+#include "config_pool.hpp"
+
+// C++
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+void hashCombine(std::size_t &seed, std::size_t value) noexcept {
+    seed ^= value + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2);
+}
+
+void hashList(std::size_t &seed, std::vector<std::string> const &list) noexcept {
+    hashCombine(seed, list.size());
+    for (auto const &item : list) {
+        hashCombine(seed, std::hash<std::string>{}(item));
+    }
+}
+
+} // namespace
+
+std::size_t hashConfig(TargetConfig const &config) noexcept {
+    std::size_t seed = 0;
+    hashList(seed, config.definitions);
+    hashList(seed, config.includeDirs);
+    hashList(seed, config.linkLibraries);
+    hashList(seed, config.linkDirs);
+    hashCombine(seed, std::hash<std::string>{}(config.precompiledHeader));
+    hashCombine(seed, std::hash<std::string>{}(config.optimization));
+    hashCombine(seed, std::hash<std::string>{}(config.enhancedInstructionSet));
+    hashCombine(seed, (config.multiProcessorCompilation ? 1u : 0u) |
+                          (config.wholeProgramOptimization ? 2u : 0u) |
+                          (config.intrinsicFunctions ? 4u : 0u) |
+                          (config.functionLevelLinking ? 8u : 0u));
+    return seed;
+}
+
+bool sameSettings(TargetConfig const &lhs, TargetConfig const &rhs) noexcept {
+    return lhs.definitions == rhs.definitions && lhs.includeDirs == rhs.includeDirs &&
+           lhs.linkLibraries == rhs.linkLibraries && lhs.linkDirs == rhs.linkDirs &&
+           lhs.precompiledHeader == rhs.precompiledHeader &&
+           lhs.optimization == rhs.optimization &&
+           lhs.enhancedInstructionSet == rhs.enhancedInstructionSet &&
+           lhs.multiProcessorCompilation == rhs.multiProcessorCompilation &&
+           lhs.wholeProgramOptimization == rhs.wholeProgramOptimization &&
+           lhs.intrinsicFunctions == rhs.intrinsicFunctions &&
+           lhs.functionLevelLinking == rhs.functionLevelLinking;
+}
+
+std::size_t shareIdenticalConfigs(ProjectData &data) {
+    // The distinct instances seen so far, by hash.
+    std::unordered_multimap<std::size_t, SharedConfig const *> pool;
+    std::size_t distinct = 0;
+
+    for (auto &target : data.targets) {
+        for (auto &[name, config] : target.configs) {
+            auto const hash = hashConfig(*config);
+
+            bool shared = false;
+            auto [begin, end] = pool.equal_range(hash);
+            for (auto it = begin; it != end && !shared; ++it) {
+                if (it->second->sameAs(config) || sameSettings(**it->second, *config)) {
+                    config.share(*it->second);
+                    shared = true;
+                }
+            }
+            if (!shared) {
+                pool.emplace(hash, &config);
+                ++distinct;
+            }
+        }
+    }
+
+    return distinct;
+}
@@ -0,0 +1,47 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2018 George Cave <gcave@stablecoder.ca>
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ */
+
+#ifndef CONFIG_POOL_HPP
+#define CONFIG_POOL_HPP
+
+// cmkizer
+#include "type_defs.hpp"
+
+// C++
+#include <cstddef>
+
+/// \return A hash of all of a config's settings.
+std::size_t hashConfig(TargetConfig const &config) noexcept;
+
+/// \return True if both configs have identical settings.
+bool sameSettings(TargetConfig const &lhs, TargetConfig const &rhs) noexcept;
+
+/// Collapses every configuration with identical settings, across all targets,
+/// into a single shared instance.
+/// \param data The project to process.
+/// \return The number of distinct configurations remaining.
+std::size_t shareIdenticalConfigs(ProjectData &data);
+
+#endif // CONFIG_POOL_HPP
@@ -31,15 +31,16 @@
 // C++
 #include <algorithm>
 #include <cstring>
-#include <fstream>
+#include <sstream>
 
-std::tuple<bool, TargetData> dspTargetParse(std::string_view filePath) {
-    std::ifstream inFile(filePath.data(), std::ios::in);
-    if (!inFile) {
-        return std::make_tuple(false, TargetData());
-    }
+std::tuple<bool, TargetData> dspTargetParse(std::string_view filePath,
+                                            std::string_view contents,
+                                            std::shared_ptr<PathTable> pathTable) {
+    std::istringstream inFile(std::string{contents});
 
     TargetData data;
+    data.fullPath = filePath;
+    data.allFiles = PathList(std::move(pathTable));
     FilterGroup *activeFilter = nullptr;
     TargetConfig *activeConfig = nullptr;
 
@@ -75,7 +76,7 @@ std::tuple<bool, TargetData> dspTargetParse(std::string_view filePath) {
             } else {
                 line.erase(0, strlen("!ELSEIF  \"$(CFG)\" == \""));
             }
-            activeConfig = &(data.configs[line.substr(0, line.length() - 1)]);
+            activeConfig = &data.configs[line.substr(0, line.length() - 1)].edit();
         } else if (line.find("# PROP Use_MFC ") != std::string::npos) {
             line.erase(0, strlen("# PROP Use_MFC "));
             data.useMFC = std::stoi(line);
@@ -31,13 +31,18 @@
 
 // C++
 #include <cstdio>
+#include <memory>
 #include <string>
 #include <tuple>
 
 /// Processes a *.dsp file.
 /// \param filePath The path to the file
+/// \param contents The contents of the file
+/// \param pathTable Receives the directories of the target's files
 /// \return A tuple returning a boolean representing if the file was parsed, and
 /// corresponding target data from a successful parsing.
-std::tuple<bool, TargetData> dspTargetParse(std::string_view filePath);
+std::tuple<bool, TargetData> dspTargetParse(std::string_view filePath,
+                                            std::string_view contents,
+                                            std::shared_ptr<PathTable> pathTable);
 
 #endif // DSP_HPP
\ No newline at end of file
@@ -31,16 +31,16 @@
 // C++
 #include <algorithm>
 #include <cstring>
-#include <fstream>
+#include <sstream>
 
-std::tuple<bool, ProjectData> dswProjectParse(std::string_view projectPath) {
+std::tuple<bool, ProjectData> dswProjectParse(std::string_view projectPath,
+                                              std::string_view contents,
+                                              FileReader const &readFile,
+                                              TargetCallback const &onTarget,
+                                              TargetSelection const &selection) {
     ProjectData data;
-    std::ifstream inFile(projectPath.data(), std::ios::in);
-    if (!inFile) {
-        return std::make_tuple(false, data);
-    }
+    std::istringstream inFile(std::string{contents});
 
-    TargetData *currentTarget = nullptr;
     std::string rootPath;
     const auto lastSlash = std::min(projectPath.find_last_of('/'), projectPath.find_last_of('\\'));
     if (lastSlash != std::string::npos) {
@@ -54,42 +54,37 @@ std::tuple<bool, ProjectData> dswProjectParse(std::string_view projectPath) {
     }
     data.path = projectPath;
 
+    // The project list is read in full first, so only the targets needed have
+    // to be parsed.
+    std::vector<ProjectEntry> entries;
+
     while (!inFile.eof()) {
         std::string line;
         std::getline(inFile, line);
 
         if (line.find("Project: \"") != std::string::npos) {
             line.erase(0, strlen("Project: \""));
-            std::string targetName = line.substr(0, line.find('\"'));
-            line.erase(0, targetName.size() + 3);
-            std::string relativePath(line.substr(0, line.find('\"')));
-            std::replace(relativePath.begin(), relativePath.end(), '\\', '/');
-            if (relativePath.find_first_of("./") == 0) {
-                relativePath.erase(0, 2);
-            }
-            std::string fullPath(rootPath + relativePath);
-            std::replace(fullPath.begin(), fullPath.end(), '\\', '/');
-            auto [read, targetData] = parseTarget(fullPath);
-
-            if (read) {
-                targetData.name = targetName;
-                targetData.displayName = targetName;
-                targetData.fullPath = fullPath;
-                targetData.relativePath = relativePath;
-                data.targets.emplace_back(targetData);
-                currentTarget = &*(data.targets.end() - 1);
-            } else {
-                currentTarget = nullptr;
-                printf("Error: Could not parse project file - %s\n", relativePath.data());
-                continue;
+            ProjectEntry entry;
+            entry.name = line.substr(0, line.find('\"'));
+            entry.displayName = entry.name;
+            line.erase(0, entry.name.size() + 3);
+            entry.relativePath = line.substr(0, line.find('\"'));
+            std::replace(entry.relativePath.begin(), entry.relativePath.end(), '\\', '/');
+            if (entry.relativePath.find_first_of("./") == 0) {
+                entry.relativePath.erase(0, 2);
             }
+            entry.fullPath = rootPath + entry.relativePath;
+            std::replace(entry.fullPath.begin(), entry.fullPath.end(), '\\', '/');
+            entries.emplace_back(std::move(entry));
         } else if (line.find("Project_Dep_Name ") != std::string::npos) {
             line.erase(0, line.find("Project_Dep_Name ") + strlen("Project_Dep_Name "));
-            if (currentTarget != nullptr) {
-                currentTarget->dependencies.emplace_back(line);
+            if (!entries.empty()) {
+                entries.back().dependencies.emplace_back(line);
             }
         }
     }
 
+    parseProjectEntries(data, entries, readFile, onTarget, selection);
+
     return std::make_tuple(true, data);
-}
\ No newline at end of file
+}
@@ -36,8 +36,17 @@
 
 /// Processes a *.dsw file.
 /// \param filePath The path to the file
+/// \param contents The contents of the file
+/// \param readFile Provides the referenced target files
 /// \return A tuple returning a boolean representing if the file was parsed, and
 /// corresponding project data from a successful parsing.
-std::tuple<bool, ProjectData> dswProjectParse(std::string_view projectPath);
+/// \param onTarget If set, receives each target as soon as it is parsed.
+/// \param selection If not empty, only these targets and their dependencies
+/// are parsed.
+std::tuple<bool, ProjectData> dswProjectParse(std::string_view projectPath,
+                                              std::string_view contents,
+                                              FileReader const &readFile,
+                                              TargetCallback const &onTarget = {},
+                                              TargetSelection const &selection = {});
 
 #endif // DSW_HPP
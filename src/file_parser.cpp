@@ -27,28 +27,62 @@
 #include "file_parser.hpp"
 #include "dsp.hpp"
 #include "dsw.hpp"
+#include "prefetch.hpp"
 #include "proj.hpp"
 #include "sln.hpp"
 #include "vfproj.hpp"
+#include "util.hpp"
 #include "xproj.hpp"
 
 // C++
 #include <algorithm>
 #include <cctype>
+#include <unordered_map>
 
-std::tuple<bool, ProjectData> parseProject(std::string_view projectPath) {
+namespace {
+
+/// The number of target files read ahead of parsing at a time.
+constexpr std::size_t cPrefetchBatchSize = 64;
+
+bool hasExtension(std::string_view path, std::string_view extension) {
+    if (path.size() < extension.size()) {
+        return false;
+    }
+    auto const suffix = path.substr(path.size() - extension.size());
+    return std::equal(suffix.begin(), suffix.end(), extension.begin(), extension.end(),
+                      [](char lhs, char rhs) { return ::tolower(lhs) == ::tolower(rhs); });
+}
+
+} // namespace
+
+std::tuple<bool, ProjectData> parseProject(std::string_view projectPath,
+                                           TargetCallback const &onTarget,
+                                           TargetSelection const &selection) {
+    auto [found, contents] = readFile(std::string{projectPath});
+    if (!found) {
+        return std::make_tuple(false, ProjectData());
+    }
+
+    return parseProject(projectPath, contents, readFile, onTarget, selection);
+}
+
+std::tuple<bool, ProjectData> parseProject(std::string_view projectPath,
+                                           std::string_view contents,
+                                           FileReader const &readFile,
+                                           TargetCallback const &onTarget,
+                                           TargetSelection const &selection) {
     // Figure out the file type.
     const auto lastDot(projectPath.find_last_of('.'));
     if (lastDot != std::string::npos) {
-        std::string ext = projectPath.data() + lastDot;
+        std::string ext(projectPath.substr(lastDot));
 
         std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
 
         if (ext == ".dsw") {
-            return dswProjectParse(projectPath);
+            return dswProjectParse(projectPath, contents, readFile, onTarget, selection);
         }
         if (ext == ".sln") {
-            return slnProjectParse(projectPath);
+            return slnProjectParse(projectPath, contents, readFile, onTarget, selection);
         }
     }
 
@@ -57,23 +91,176 @@ std::tuple<bool, ProjectData> parseProject(std::string_view projectPath) {
 }
 
 std::tuple<bool, TargetData> parseTarget(std::string_view targetPath) {
+    auto [found, contents] = readFile(std::string{targetPath});
+    if (!found) {
+        return std::make_tuple(false, TargetData());
+    }
+
+    return parseTarget(targetPath, contents, readFile);
+}
+
+std::tuple<bool, TargetData> parseTarget(std::string_view targetPath,
+                                         std::string_view contents,
+                                         FileReader const &readFile,
+                                         std::shared_ptr<PathTable> pathTable) {
+    if (pathTable == nullptr) {
+        pathTable = std::make_shared<PathTable>();
+    }
+
     const auto lastDot = targetPath.find_last_of('.');
     if (lastDot != std::string::npos) {
-        std::string ext = targetPath.data() + lastDot;
+        std::string ext(targetPath.substr(lastDot));
 
         if (ext == ".dsp") {
-            return dspTargetParse(targetPath);
+            return dspTargetParse(targetPath, contents, std::move(pathTable));
         }
         if (ext == ".vcproj") {
-            return projTargetParse(targetPath);
+            return projTargetParse(targetPath, contents, std::move(pathTable));
         }
         if (ext == ".vcxproj") {
-            return xprojTargetParse(targetPath);
+            return xprojTargetParse(targetPath, contents, readFile, std::move(pathTable));
         }
         if (ext == ".vfproj") {
-            return vfprojTargetParse(targetPath);
+            return vfprojTargetParse(targetPath, contents, std::move(pathTable));
         }
     }
 
     return std::make_tuple(false, TargetData());
-};
\ No newline at end of file
+}
+
+void parseProjectEntries(ProjectData &data,
+                         std::vector<ProjectEntry> const &entries,
+                         FileReader const &readFile,
+                         TargetCallback const &onTarget,
+                         TargetSelection const &selection) {
+    auto toUpper = [](std::string str) {
+        std::transform(str.begin(), str.end(), str.begin(), ::toupper);
+        return str;
+    };
+
+    // Dependencies may refer to an entry by either name, GUIDs differ in case
+    // between solutions and ProjectReferences.
+    std::unordered_map<std::string, std::size_t> entryIndices;
+    for (std::size_t i = 0; i < entries.size(); ++i) {
+        entryIndices.try_emplace(toUpper(entries[i].displayName), i);
+        entryIndices.try_emplace(toUpper(entries[i].name), i);
+    }
+
+    std::vector<bool> wanted(entries.size(), selection.empty());
+    std::vector<bool> parsed(entries.size(), false);
+    std::vector<std::size_t> pending;
+
+    auto want = [&](std::string const &name) {
+        auto it = entryIndices.find(toUpper(name));
+        if (it == entryIndices.end()) {
+            return false;
+        }
+        if (!wanted[it->second]) {
+            wanted[it->second] = true;
+            pending.emplace_back(it->second);
+        }
+        return true;
+    };
+
+    for (auto const &name : selection) {
+        if (!want(name)) {
+            data.diagnostics.emplace_back("Warning: Selected target not found - " + name);
+        }
+    }
+    // Closure over the dependencies the project file lists itself.
+    while (!pending.empty()) {
+        auto idx = pending.back();
+        pending.pop_back();
+        for (auto const &dependency : entries[idx].dependencies) {
+            want(dependency);
+        }
+    }
+
+    bool foundMore = true;
+    while (foundMore) {
+        foundMore = false;
+
+        std::vector<std::size_t> round;
+        for (std::size_t i = 0; i < entries.size(); ++i) {
+            if (wanted[i] && !parsed[i]) {
+                round.emplace_back(i);
+                parsed[i] = true;
+            }
+        }
+
+        for (std::size_t batchStart = 0; batchStart < round.size();
+             batchStart += cPrefetchBatchSize) {
+            auto const batchEnd = std::min(round.size(), batchStart + cPrefetchBatchSize);
+
+            // All the files of a batch are read together ahead of parsing, the
+            // parsers then take over the buffers.
+            std::vector<std::string> paths;
+            for (auto i = batchStart; i < batchEnd; ++i) {
+                auto const &fullPath = entries[round[i]].fullPath;
+                paths.emplace_back(fullPath);
+                if (hasExtension(fullPath, ".vcxproj")) {
+                    paths.emplace_back(fullPath + ".filters");
+                }
+            }
+            auto contents = prefetchFiles(paths, readFile);
+
+            std::unordered_map<std::string, std::tuple<bool, std::string>> prefetched;
+            for (std::size_t i = 0; i < paths.size(); ++i) {
+                prefetched.try_emplace(std::move(paths[i]), std::move(contents[i]));
+            }
+            FileReader readPrefetched = [&](std::string const &path) {
+                auto it = prefetched.find(path);
+                if (it == prefetched.end()) {
+                    return readFile(path);
+                }
+                auto retVal = std::move(it->second);
+                prefetched.erase(it);
+                return retVal;
+            };
+
+            for (auto i = batchStart; i < batchEnd; ++i) {
+                auto const &entry = entries[round[i]];
+
+                auto [found, targetContents] = readPrefetched(entry.fullPath);
+                auto [read, target] =
+                    found ? parseTarget(entry.fullPath, targetContents, readPrefetched,
+                                        data.pathTable)
+                          : std::make_tuple(false, TargetData());
+                if (!read) {
+                    data.diagnostics.emplace_back("Error: Could not parse project file - " +
+                                                  entry.relativePath);
+                    continue;
+                }
+
+                target.name = entry.name;
+                target.displayName = entry.displayName;
+                target.fullPath = entry.fullPath;
+                target.relativePath = entry.relativePath;
+                target.dependencies.insert(target.dependencies.end(),
+                                           entry.dependencies.begin(), entry.dependencies.end());
+
+                if (!selection.empty()) {
+                    // References only found in the target file itself are
+                    // pulled in by a further round.
+                    for (auto const &dependency : target.dependencies) {
+                        want(dependency);
+                    }
+                    while (!pending.empty()) {
+                        auto idx = pending.back();
+                        pending.pop_back();
+                        foundMore = true;
+                        for (auto const &dependency : entries[idx].dependencies) {
+                            want(dependency);
+                        }
+                    }
+                }
+
+                if (onTarget) {
+                    onTarget(target);
+                } else {
+                    data.targets.emplace_back(std::move(target));
+                }
+            }
+        }
+    }
+}
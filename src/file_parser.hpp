@@ -30,15 +30,67 @@
 #include "type_defs.hpp"
 
 // C++
+#include <memory>
 #include <string>
 #include <string_view>
 #include <tuple>
+#include <vector>
+
+/// A target listed by a project file, before the target's own file is parsed.
+struct ProjectEntry {
+    std::string name;
+    std::string displayName;
+    std::string relativePath;
+    std::string fullPath;
+    /// Dependencies listed by the project file itself
+    std::vector<std::string> dependencies;
+};
 
 /// \brief Parses a project file, typically a .sln file.
 /// \param projectPath The path to the project file to parse.
+/// \param onTarget If set, receives each target as soon as it is parsed.
+/// \param selection If not empty, only these targets and their dependencies
+/// are parsed.
+/// \return A boolean representing th success, and ProjectData for a successful
+/// parse.
+std::tuple<bool, ProjectData> parseProject(std::string_view projectPath,
+                                           TargetCallback const &onTarget = {},
+                                           TargetSelection const &selection = {});
+
+/// \brief Parses a project file already held in memory.
+/// \param projectPath The path of the project file, its extension determines
+/// the type and referenced targets are relative to it.
+/// \param contents The contents of the project file.
+/// \param readFile Provides the contents of the referenced target files.
+/// \param onTarget If set, receives each target as soon as it is parsed.
+/// \param selection If not empty, only these targets and their dependencies
+/// are parsed.
 /// \return A boolean representing th success, and ProjectData for a successful
 /// parse.
-std::tuple<bool, ProjectData> parseProject(std::string_view projectPath);
+std::tuple<bool, ProjectData> parseProject(std::string_view projectPath,
+                                           std::string_view contents,
+                                           FileReader const &readFile,
+                                           TargetCallback const &onTarget = {},
+                                           TargetSelection const &selection = {});
+
+/// \brief Parses the targets listed by a project file.
+///
+/// With a selection, the closure of the selected entries over the listed
+/// dependencies is parsed first, then any further dependencies discovered in
+/// the parsed targets themselves (such as a vcxproj's ProjectReferences) are
+/// pulled in, until nothing new is found. Entries are always parsed in listed
+/// order within each round.
+/// \param data The project, receives the targets and diagnostics.
+/// \param entries The targets listed by the project file.
+/// \param readFile Provides the contents of the target files.
+/// \param onTarget If set, receives each target as soon as it is parsed.
+/// \param selection If not empty, only these targets and their dependencies
+/// are parsed.
+void parseProjectEntries(ProjectData &data,
+                         std::vector<ProjectEntry> const &entries,
+                         FileReader const &readFile,
+                         TargetCallback const &onTarget,
+                         TargetSelection const &selection);
 
 /// \brief Parses a target file, typically a .vcproj or vcxproj file.
 /// \param projectPath The path to the target file to parse.
@@ -46,6 +98,21 @@ std::tuple<bool, ProjectData> parseProject(std::string_view projectPath);
 /// parse.
 std::tuple<bool, TargetData> parseTarget(std::string_view targetPath);
 
+/// \brief Parses a target file already held in memory.
+/// \param targetPath The path of the target file, its extension determines the
+/// type.
+/// \param contents The contents of the target file.
+/// \param readFile Provides the contents of any accompanying files, such as a
+/// vcxproj's '.filters' file.
+/// \param pathTable Receives the directories of the target's files, a table of
+/// the target's own if not set.
+/// \return A boolean representing th success, and TargetData for a successful
+/// parse.
+std::tuple<bool, TargetData> parseTarget(std::string_view targetPath,
+                                         std::string_view contents,
+                                         FileReader const &readFile,
+                                         std::shared_ptr<PathTable> pathTable = {});
+
 // std::tuple<bool, SetupData> parseSetup(const std::string& setupPath);
 
 #endif // FILE_PARSER_HPP
@@ -25,135 +25,573 @@
 
 #include "generators.hpp"
 
+#include "config_pool.hpp"
+#include "graph.hpp"
+#include "parallel.hpp"
 #include "util.hpp"
 
 #include <algorithm>
 #include <cctype>
+#include <filesystem>
+#include <set>
 #include <tuple>
+#include <unordered_map>
+#include <unordered_set>
 
-ProjectData projectPreprocessing(ProjectData data, GlobalSettings &globalSettings) {
-    if (data.targets.empty()) {
-        // Do nothing, there are no targets.
-        return data;
+std::string targetDirectory(TargetData const &target) {
+    auto lastSlash = target.relativePath.find_last_of('/');
+    if (lastSlash == std::string::npos) {
+        return {};
+    }
+    return target.relativePath.substr(0, lastSlash);
+}
+
+std::string buildType(std::string_view configName) {
+    std::string retVal;
+    if (auto split = configName.find('|'); split != std::string_view::npos) {
+        retVal = configName.substr(0, split);
+    } else if (auto split = configName.find(" - "); split != std::string_view::npos) {
+        retVal = configName.substr(configName.find_last_of(' ') + 1);
+    } else {
+        retVal = configName;
     }
+    std::replace(retVal.begin(), retVal.end(), ' ', '_');
+    return retVal;
+}
+
+std::map<std::string, SharedConfig>::const_iterator selectConfig(TargetData const &target,
+                                                                 std::string_view name) {
+    if (auto it = target.configs.find(std::string{name}); it != target.configs.end()) {
+        return it;
+    }
+    if (name.empty()) {
+        return target.configs.begin();
+    }
+
+    auto lowerType = [](std::string type) {
+        std::transform(type.begin(), type.end(), type.begin(), ::tolower);
+        return type;
+    };
+    auto const wanted = lowerType(buildType(name));
+    return std::find_if(target.configs.begin(), target.configs.end(), [&](auto const &config) {
+        return lowerType(buildType(config.first)) == wanted;
+    });
+}
+
+std::vector<std::string> performanceOptions(TargetConfig const &config, bool msvc) {
+    std::vector<std::string> options;
 
-    // Remove typical OS-specific flags that are given to targets by default.
-    for (auto &target : data.targets) {
-        for (auto &[name, config] : target.configs) {
-            removeDefaultDefinitions(config.definitions);
-            removeDefaultIncludes(config.includeDirs);
+    constexpr const char *cOptimizations[][3] = {{"Disabled", "/Od", "-O0"},
+                                                 {"MinSpace", "/O1", "-Os"},
+                                                 {"MaxSpeed", "/O2", "-O2"},
+                                                 {"Full", "/Ox", "-O3"}};
+    for (auto const &level : cOptimizations) {
+        if (config.optimization == level[0]) {
+            options.emplace_back(level[msvc ? 1 : 2]);
         }
     }
 
-    // Link project dependencies
-    for (auto &target : data.targets) {
-        for (auto &dependency : target.dependencies) {
-            std::string comp1 = dependency;
-            std::transform(comp1.begin(), comp1.end(), comp1.begin(), ::toupper);
-
-            for (auto &otherTarget : data.targets) {
-                std::string comp2 = otherTarget.displayName;
-                std::transform(comp2.begin(), comp2.end(), comp2.begin(), ::toupper);
-
-                if (comp1 == comp2) {
-                    for (auto &[name, config] : target.configs) {
-                        config.linkLibraries.emplace_back(otherTarget.name);
-                    }
-                    break;
+    constexpr const char *cInstructionSets[][3] = {
+        {"StreamingSIMDExtensions", "/arch:SSE", "-msse"},
+        {"StreamingSIMDExtensions2", "/arch:SSE2", "-msse2"},
+        {"AdvancedVectorExtensions", "/arch:AVX", "-mavx"},
+        {"AdvancedVectorExtensions2", "/arch:AVX2", "-mavx2"},
+        {"AdvancedVectorExtensions512", "/arch:AVX512", "-mavx512f"},
+        {"NoExtensions", "/arch:IA32", ""},
+        {"IA32", "/arch:IA32", ""}};
+    for (auto const &set : cInstructionSets) {
+        if (config.enhancedInstructionSet == set[0] && *set[msvc ? 1 : 2] != '\0') {
+            options.emplace_back(set[msvc ? 1 : 2]);
+        }
+    }
+
+    if (msvc) {
+        if (config.multiProcessorCompilation) {
+            options.emplace_back("/MP");
+        }
+        if (config.intrinsicFunctions) {
+            options.emplace_back("/Oi");
+        }
+        if (config.functionLevelLinking) {
+            options.emplace_back("/Gy");
+        }
+    } else if (config.functionLevelLinking) {
+        options.emplace_back("-ffunction-sections");
+    }
+
+    return options;
+}
+
+std::string precompiledHeaderFile(TargetData const &target, TargetConfig const &config) {
+    std::string header = config.precompiledHeader;
+    std::replace(header.begin(), header.end(), '\\', '/');
+    if (header.empty()) {
+        return header;
+    }
+    for (auto const &[filterName, filter] : target.filters) {
+        for (auto const &file : filter.files) {
+            if (file == header || (file.size() > header.size() &&
+                                   file.compare(file.size() - header.size() - 1,
+                                                std::string::npos, "/" + header) == 0)) {
+                return file;
+            }
+        }
+    }
+    return header;
+}
+
+namespace {
+
+/// The definitions and project-relative include directories of a config.
+struct SettingSets {
+    std::set<std::string> definitions;
+    std::set<std::string> includeDirs;
+};
+
+/// Moves definitions and include directories that are shared by most targets,
+/// per configuration, into a single INTERFACE target that they link instead.
+///
+/// A setting is a candidate when more than half of the targets with that
+/// configuration (and at least two) use it. Only targets that use every
+/// candidate of each of their configurations consume the common target, so no
+/// target gains settings it did not have.
+void hoistCommonSettings(ProjectData &data) {
+    if (data.targets.size() < 2) {
+        return;
+    }
+
+    // Gather each target's settings, with includes made relative to the project.
+    std::vector<std::map<std::string, SettingSets>> targetSettings(data.targets.size());
+    std::map<std::string, std::map<std::string, int>> definitionCounts;
+    std::map<std::string, std::map<std::string, int>> includeCounts;
+    std::map<std::string, int> configCounts;
+
+    for (std::size_t i = 0; i < data.targets.size(); ++i) {
+        auto const directory = targetDirectory(data.targets[i]);
+
+        for (auto const &[name, config] : data.targets[i].configs) {
+            auto &sets = targetSettings[i][name];
+            for (auto const &def : config->definitions) {
+                if (sets.definitions.insert(def).second) {
+                    ++definitionCounts[name][def];
                 }
             }
+            for (auto const &inc : config->includeDirs) {
+                if (sets.includeDirs.insert(rebasePath(directory, inc)).second) {
+                    ++includeCounts[name][rebasePath(directory, inc)];
+                }
+            }
+            ++configCounts[name];
+        }
+    }
+
+    std::map<std::string, SettingSets> candidates;
+    for (auto const &[name, targetCount] : configCounts) {
+        auto &candidate = candidates[name];
+        for (auto const &[def, count] : definitionCounts[name]) {
+            if (count >= 2 && count * 2 > targetCount) {
+                candidate.definitions.insert(def);
+            }
+        }
+        for (auto const &[inc, count] : includeCounts[name]) {
+            if (count >= 2 && count * 2 > targetCount) {
+                candidate.includeDirs.insert(inc);
+            }
         }
     }
 
-    // Convert include paths to correct slash format
-    for (auto &target : data.targets) {
-        for (auto &it : target.allFiles) {
-            std::replace(it.begin(), it.end(), '\\', '/');
-            std::replace(it.begin(), it.end(), ';', ' ');
+    // Determine the consumers, and what all of them have in common.
+    std::vector<std::size_t> consumers;
+    std::map<std::string, SettingSets> common;
+    for (std::size_t i = 0; i < data.targets.size(); ++i) {
+        bool consumer = !targetSettings[i].empty();
+        for (auto const &[name, sets] : targetSettings[i]) {
+            auto const &candidate = candidates[name];
+            consumer = consumer &&
+                       std::includes(sets.definitions.begin(), sets.definitions.end(),
+                                     candidate.definitions.begin(), candidate.definitions.end()) &&
+                       std::includes(sets.includeDirs.begin(), sets.includeDirs.end(),
+                                     candidate.includeDirs.begin(), candidate.includeDirs.end());
+        }
+        if (!consumer) {
+            continue;
         }
 
-        for (auto &[name, config] : target.configs) {
-            for (auto &include : config.includeDirs) {
-                std::replace(include.begin(), include.end(), '\\', '/');
-                std::replace(include.begin(), include.end(), ';', ' ');
+        consumers.emplace_back(i);
+        for (auto const &[name, sets] : targetSettings[i]) {
+            auto it = common.find(name);
+            if (it == common.end()) {
+                common[name] = sets;
+                continue;
+            }
+            for (auto def = it->second.definitions.begin(); def != it->second.definitions.end();) {
+                def = sets.definitions.count(*def) ? std::next(def)
+                                                   : it->second.definitions.erase(def);
+            }
+            for (auto inc = it->second.includeDirs.begin(); inc != it->second.includeDirs.end();) {
+                inc = sets.includeDirs.count(*inc) ? std::next(inc)
+                                                   : it->second.includeDirs.erase(inc);
             }
-            for (auto &include : config.linkLibraries) {
-                std::replace(include.begin(), include.end(), '\\', '/');
-                std::replace(include.begin(), include.end(), ';', ' ');
+        }
+    }
+
+    bool anyCommon = false;
+    for (auto const &[name, sets] : common) {
+        anyCommon = anyCommon || !sets.definitions.empty() || !sets.includeDirs.empty();
+    }
+    if (consumers.size() < 2 || !anyCommon) {
+        return;
+    }
+
+    data.commonTarget = data.name + "_common";
+    std::replace(data.commonTarget.begin(), data.commonTarget.end(), ' ', '_');
+
+    // Move the common settings out of the consumers, keeping their original order.
+    for (auto idx : consumers) {
+        auto &target = data.targets[idx];
+        auto const directory = targetDirectory(target);
+
+        for (auto &[name, sharedConfig] : target.configs) {
+            auto &config = sharedConfig.edit();
+            auto const &sets = common[name];
+            auto &commonConfig = data.commonConfigs[name];
+
+            for (auto it = config.definitions.begin(); it != config.definitions.end();) {
+                if (sets.definitions.count(*it) == 0) {
+                    ++it;
+                    continue;
+                }
+                if (std::find(commonConfig.definitions.begin(), commonConfig.definitions.end(),
+                              *it) == commonConfig.definitions.end()) {
+                    commonConfig.definitions.emplace_back(*it);
+                }
+                it = config.definitions.erase(it);
             }
-            for (auto &include : config.linkDirs) {
-                std::replace(include.begin(), include.end(), '\\', '/');
-                std::replace(include.begin(), include.end(), ';', ' ');
+            for (auto it = config.includeDirs.begin(); it != config.includeDirs.end();) {
+                auto rebased = rebasePath(directory, *it);
+                if (sets.includeDirs.count(rebased) == 0) {
+                    ++it;
+                    continue;
+                }
+                if (std::find(commonConfig.includeDirs.begin(), commonConfig.includeDirs.end(),
+                              rebased) == commonConfig.includeDirs.end()) {
+                    commonConfig.includeDirs.emplace_back(std::move(rebased));
+                }
+                it = config.includeDirs.erase(it);
             }
+
+            config.linkLibraries.insert(config.linkLibraries.begin(), data.commonTarget);
         }
+    }
+}
+
+/// Determines the pointer size implied by the platform of a MSVS
+/// configuration name, or 0 if it cannot be determined.
+int platformPointerSize(std::string_view configName) {
+    std::string platform;
+    if (auto split = configName.find('|'); split != std::string_view::npos) {
+        platform = configName.substr(split + 1);
+    } else if (auto split = configName.find(" - "); split != std::string_view::npos) {
+        platform = configName.substr(split + 3);
+    }
+    std::transform(platform.begin(), platform.end(), platform.begin(), ::tolower);
 
-        for (auto &[name, filter] : target.filters) {
-            for (auto &it : filter.files) {
-                std::replace(it.begin(), it.end(), '\\', '/');
-                std::replace(it.begin(), it.end(), ';', ' ');
+    if (platform.find("64") != std::string::npos) {
+        return 8;
+    }
+    if (platform.find("win32") != std::string::npos || platform.find("x86") != std::string::npos) {
+        return 4;
+    }
+    return 0;
+}
+
+/// Builds the generator expression condition that selects each configuration.
+/// The platform is only checked when it is needed to tell apart configurations
+/// of the same build type.
+std::vector<std::string> configConditions(std::vector<std::string> const &configNames) {
+    std::vector<std::string> conditions;
+
+    for (auto const &name : configNames) {
+        auto const type = buildType(name);
+        auto const pointerSize = platformPointerSize(name);
+        std::string condition = "$<CONFIG:" + type + ">";
+
+        bool ambiguous = false;
+        for (auto const &other : configNames) {
+            ambiguous = ambiguous || (other != name && buildType(other) == type &&
+                                      platformPointerSize(other) != pointerSize);
+        }
+        if (ambiguous && pointerSize != 0) {
+            condition = "$<AND:" + condition + ",$<EQUAL:${CMAKE_SIZEOF_VOID_P}," +
+                        std::to_string(pointerSize) + ">>";
+        }
+
+        conditions.emplace_back(std::move(condition));
+    }
+
+    return conditions;
+}
+
+/// Writes a command such as target_compile_definitions covering every
+/// configuration at once. Items used by all configurations are written as-is,
+/// the rest are wrapped in generator expressions for the configurations using
+/// them.
+/// \param conditions The condition selecting each configuration.
+/// \param classes The configurations, as indices into conditions, of each class
+/// of configurations with identical settings.
+/// \param lists The command's items for each class.
+void writeConfigCommand(std::string &out,
+                        char const *command,
+                        std::string_view target,
+                        char const *scope,
+                        std::vector<std::string> const &conditions,
+                        std::vector<std::vector<std::size_t>> const &classes,
+                        std::vector<std::vector<std::string> const *> const &lists) {
+    // Items in order of first appearance, with the classes using them.
+    std::vector<std::pair<std::string_view, std::vector<std::size_t>>> items;
+    std::map<std::string_view, std::size_t> itemIndices;
+    for (std::size_t i = 0; i < lists.size(); ++i) {
+        for (auto const &item : *lists[i]) {
+            auto [it, inserted] = itemIndices.try_emplace(item, items.size());
+            if (inserted) {
+                items.emplace_back(item, std::vector<std::size_t>{});
+            }
+            auto &users = items[it->second].second;
+            if (users.empty() || users.back() != i) {
+                users.emplace_back(i);
             }
         }
     }
+    if (items.empty()) {
+        return;
+    }
 
-    // Eliminate duplicate files from the 'allFiles' that are already in a filter group
-    for (auto &target : data.targets) {
+    appendf(out, "%s( %.*s%s", command, static_cast<int>(target.size()), target.data(), scope);
+    for (auto const &[item, users] : items) {
+        if (users.size() == lists.size()) {
+            appendf(out, " %.*s", static_cast<int>(item.size()), item.data());
+            continue;
+        }
 
-        for (auto it = target.allFiles.begin(); it != target.allFiles.end();) {
-            bool found{false};
+        std::vector<std::size_t> userConfigs;
+        for (auto idx : users) {
+            userConfigs.insert(userConfigs.end(), classes[idx].begin(), classes[idx].end());
+        }
+        std::sort(userConfigs.begin(), userConfigs.end());
 
-            for (auto &[name, filter] : target.filters) {
-                for (auto &file : filter.files) {
-                    if (file == *it) {
-                        found = true;
-                        break;
-                    }
-                }
+        std::vector<std::string_view> userConditions;
+        for (auto idx : userConfigs) {
+            if (std::find(userConditions.begin(), userConditions.end(), conditions[idx]) ==
+                userConditions.end()) {
+                userConditions.emplace_back(conditions[idx]);
             }
+        }
+        std::string condition;
+        if (userConditions.size() == 1) {
+            condition = userConditions[0];
+        } else {
+            condition = "$<OR:";
+            for (auto userCondition : userConditions) {
+                condition += userCondition;
+                condition += ',';
+            }
+            condition.back() = '>';
+        }
 
-            if (found)
-                it = target.allFiles.erase(it);
-            else
-                ++it;
+        std::string escaped;
+        for (char ch : item) {
+            if (ch == ',') {
+                escaped += "$<COMMA>";
+            } else if (ch == '>') {
+                escaped += "$<ANGLE-R>";
+            } else {
+                escaped += ch;
+            }
         }
+        appendf(out, " $<%s:%s>", condition.data(), escaped.data());
     }
+    appendf(out, " )\n");
+}
 
-    // Check for QT items
-    for (auto &target : data.targets) {
-        for (auto &[it, filter] : target.filters) {
-            // Check file for QT MOC/UIC/RCC options.
+/// Converts a path to the correct slash format.
+void convertPath(std::string &path) {
+    for (auto &ch : path) {
+        if (ch == '\\') {
+            ch = '/';
+        } else if (ch == ';') {
+            ch = ' ';
+        }
+    }
+}
 
-            auto qtFile = filter.files.begin();
-            while (qtFile != filter.files.end()) {
-                auto start = qtFile->find_last_of('/');
-                if (start == std::string::npos) {
-                    start = 0;
-                } else {
-                    ++start;
-                }
-                auto end = qtFile->find_last_of('.');
-                std::string_view fileName(qtFile->data() + start, end - start);
-                std::string_view ext = qtFile->data() + end;
-
-                if (fileName.find("moc_") != std::string::npos || ext == ".moc" ||
-                    fileName.find("qrc_") != std::string::npos || ext == ".qrc" ||
-                    fileName.find("ui_") != std::string::npos || ext == ".ui") {
-                    target.useQt = true;
-
-                    if (globalSettings.qtVersion == 0) {
-                        globalSettings.qtVersion = 5;
-                    }
-                }
+/// Moves a list onto a table, if it uses another one.
+void useTable(PathList &files, std::shared_ptr<PathTable> const &table) {
+    if (files.table() != table) {
+        files = PathList(files.paths(), table);
+    }
+}
 
-                ++qtFile;
+/// Converts the paths of a list, each directory only once.
+/// \param directories The directories converted so far, and what they became.
+void convertPaths(PathList &files, std::unordered_map<std::uint32_t, std::uint32_t> &directories) {
+    if (files.empty()) {
+        return;
+    }
+    auto &table = *files.table();
+    for (std::size_t i = 0; i < files.size(); ++i) {
+        auto const &entry = files.entries()[i];
+        auto [it, inserted] = directories.try_emplace(entry.directory, entry.directory);
+        if (inserted) {
+            std::string directory = table.path(entry.directory);
+            if (directory.find_first_of("\\;") != std::string::npos) {
+                convertPath(directory);
+                it->second = table.intern(directory);
             }
         }
+        if (it->second != entry.directory || entry.leaf.find(';') != std::string::npos) {
+            std::string path = table.path(it->second) + entry.leaf;
+            convertPath(path);
+            files.assign(i, path);
+        }
+    }
+}
+
+/// Places a generated file within the output directory, at its path relative
+/// to the directory of the converted input.
+/// \return False if the file would end up outside of the output directory, and
+/// otherwise the path to write it to.
+std::tuple<bool, std::string> outputFilePath(std::string const &filePath,
+                                             std::string_view outputDir,
+                                             std::string_view baseDir) {
+    namespace fs = std::filesystem;
+    std::error_code error;
+    auto absolutePath = [&](fs::path const &path) {
+        auto retVal = fs::absolute(path.empty() ? fs::path(".") : path, error).lexically_normal();
+        return retVal.has_filename() ? retVal : retVal.parent_path();
+    };
+
+    // Both made absolute first, a relative file may still lead out of the base.
+    auto const relative = absolutePath(filePath).lexically_relative(absolutePath(baseDir));
+    if (relative.empty() || relative.is_absolute() || *relative.begin() == "..") {
+        return std::make_tuple(false, std::string{});
     }
 
+    // Existing links within the output directory may lead elsewhere still.
+    auto const root = fs::weakly_canonical(absolutePath(outputDir), error);
+    auto const resolved = fs::weakly_canonical(root / relative, error).lexically_relative(root);
+    if (error || resolved.empty() || *resolved.begin() == "..") {
+        return std::make_tuple(false, std::string{});
+    }
+
+    return std::make_tuple(true, (fs::path(outputDir) / relative).generic_string());
+}
+
+/// Checks whether a file is one of the QT MOC/UIC/RCC items.
+bool isQtFile(std::string_view file) {
+    auto start = file.find_last_of('/');
+    if (start == std::string_view::npos) {
+        start = 0;
+    } else {
+        ++start;
+    }
+    auto end = file.find_last_of('.');
+    if (end == std::string_view::npos || end < start) {
+        end = file.size();
+    }
+    auto fileName = file.substr(start, end - start);
+    auto ext = file.substr(end);
+
+    return fileName.find("moc_") != std::string_view::npos || ext == ".moc" ||
+           fileName.find("qrc_") != std::string_view::npos || ext == ".qrc" ||
+           fileName.find("ui_") != std::string_view::npos || ext == ".ui";
+}
+
+} // namespace
+
+void preprocessTarget(TargetData &target) {
+    // Configurations: remove typical OS-specific flags that are given to
+    // targets by default, and convert paths to the correct slash format.
+    for (auto &[name, sharedConfig] : target.configs) {
+        auto &config = sharedConfig.edit();
+        removeDefaultDefinitions(config.definitions);
+        removeDefaultIncludes(config.includeDirs);
+        for (auto *list : {&config.includeDirs, &config.linkLibraries, &config.linkDirs}) {
+            for (auto &path : *list) {
+                convertPath(path);
+            }
+        }
+    }
+
+    // Directories are compared by id across the lists, so they must all use
+    // one table, as they do when parsed.
+    if (target.allFiles.table() == nullptr) {
+        target.allFiles = PathList(std::make_shared<PathTable>());
+    }
+    for (auto &[name, filter] : target.filters) {
+        useTable(filter.files, target.allFiles.table());
+    }
+
+    // Filter groups: convert paths, noting them per directory for the
+    // duplicate check and checking for QT items along the way.
+    std::unordered_map<std::uint32_t, std::uint32_t> directories;
+    std::unordered_map<std::uint32_t, std::unordered_set<std::string_view>> filterFiles;
+    for (auto &[name, filter] : target.filters) {
+        convertPaths(filter.files, directories);
+        for (auto const &entry : filter.files.entries()) {
+            filterFiles[entry.directory].emplace(entry.leaf);
+            if (isQtFile(entry.leaf)) {
+                target.useQt = true;
+            }
+        }
+    }
+
+    // Convert the remaining files, eliminating those that are already in a
+    // filter group.
+    convertPaths(target.allFiles, directories);
+    target.allFiles.removeIf([&](PathList::Entry const &entry) {
+        auto it = filterFiles.find(entry.directory);
+        return it != filterFiles.end() && it->second.count(entry.leaf) != 0;
+    });
+}
+
+ProjectData projectPreprocessing(ProjectData data) {
+    if (data.targets.empty()) {
+        // Do nothing, there are no targets.
+        return data;
+    }
+
+    // Every target is processed on its own, so they can be done in parallel.
+    parallelFor(data.targets.size(), 0,
+                [&](std::size_t idx) { preprocessTarget(data.targets[idx]); });
+
+    // Link project dependencies
+    data.dependencyGraph = buildDependencyGraph(data);
+    for (std::size_t i = 0; i < data.targets.size(); ++i) {
+        for (auto dependency : data.dependencyGraph.dependencies[i]) {
+            for (auto &[name, config] : data.targets[i].configs) {
+                config.edit().linkLibraries.emplace_back(data.targets[dependency].name);
+            }
+        }
+    }
+    for (auto const &cycle : findCycles(data.dependencyGraph)) {
+        data.diagnostics.emplace_back("Warning: Cyclic dependency between targets - " +
+                                      describeCycle(data, cycle));
+    }
+
+    // Hoist settings shared by most targets into a common INTERFACE target
+    hoistCommonSettings(data);
+
+    // Identical configurations share one instance, which the generator then
+    // handles once.
+    shareIdenticalConfigs(data);
+
     return data;
 }
 
-void generateCMakeProject(const ProjectData &projectData, GlobalSettings const &globalSettings) {
-    // Open own file.
+void generateCMakeProject(const ProjectData &projectData,
+                          GlobalSettings const &globalSettings,
+                          GeneratedFiles &files) {
+    // Own file.
     std::string outFilePath;
     auto lastSlash =
         std::min(projectData.path.find_last_of('/'), projectData.path.find_last_of('\\'));
@@ -164,50 +602,115 @@ void generateCMakeProject(const ProjectData &projectData, GlobalSettings const &
         outFilePath = projectData.path.substr(0, lastSlash);
     }
     outFilePath += cCmakeFilename;
-    FILE *pOut = fopen(outFilePath.c_str(), "w");
-    if (pOut == nullptr) {
-        printf("cmkizer: Failed to open file to send CMake output to - %s", outFilePath.c_str());
-        return;
-    }
+    std::string &out = files[outFilePath];
+    out.clear();
 
-    fprintf(pOut, "cmake_minimum_required( VERSION %s )\n", globalSettings.cmakeVersion.data());
+    appendf(out, "cmake_minimum_required( VERSION %s )\n", globalSettings.cmakeVersion.data());
     if (projectData.name.find(' ') == std::string::npos) {
         // Project name has no spaces
-        fprintf(pOut, "project ( %s )\n\n", projectData.name.data());
+        appendf(out, "project ( %s )\n\n", projectData.name.data());
     } else {
         // Project name has spaces
-        fprintf(pOut, "project ( \"%s\" )\n\n", projectData.name.data());
+        appendf(out, "project ( \"%s\" )\n\n", projectData.name.data());
     }
 
-    for (auto &target : projectData.targets) {
-        if (target.relativePath.find('/') == std::string::npos) {
-            // Put it in the same file, since it's in the same folder.
-            fprintf(pOut, "\n\n# %s Target\n", target.name.data());
-            generateCMakeTarget(target, globalSettings, pOut);
-        } else {
-            generateCMakeTarget(target, globalSettings, nullptr);
-            if (target.relativePath.find('"') != std::string::npos) {
-                // If the path has a space in it, surround with quotes.
-                fprintf(
-                    pOut, "add_subdirectory( \"%s\" )\n",
-                    target.relativePath.substr(0, target.relativePath.find_last_of('/')).data());
-            } else {
-                fprintf(
-                    pOut, "add_subdirectory( %s )\n",
-                    target.relativePath.substr(0, target.relativePath.find_last_of('/')).data());
+    // Common Settings
+    if (!projectData.commonTarget.empty()) {
+        appendf(out, "# Common Settings\n");
+        appendf(out, "add_library( %s INTERFACE )\n", projectData.commonTarget.data());
+
+        std::vector<std::string> configNames;
+        std::vector<std::vector<std::string>> includeDirs;
+        for (auto &[name, config] : projectData.commonConfigs) {
+            configNames.emplace_back(name);
+
+            // The include directories are relative to the project.
+            auto &dirs = includeDirs.emplace_back();
+            for (auto &inc : config.includeDirs) {
+                if (inc == ".") {
+                    dirs.emplace_back("${CMAKE_CURRENT_SOURCE_DIR}");
+                } else if (!isAbsolutePath(inc)) {
+                    dirs.emplace_back("${CMAKE_CURRENT_SOURCE_DIR}/" + inc);
+                } else {
+                    dirs.emplace_back(inc);
+                }
             }
         }
+        auto const conditions = configConditions(configNames);
+        std::vector<std::vector<std::size_t>> classes;
+        for (std::size_t i = 0; i < configNames.size(); ++i) {
+            classes.push_back({i});
+        }
+
+        std::vector<std::vector<std::string> const *> lists;
+        for (auto &[name, config] : projectData.commonConfigs) {
+            lists.emplace_back(&config.definitions);
+        }
+        writeConfigCommand(out, "target_compile_definitions", projectData.commonTarget,
+                           " INTERFACE", conditions, classes, lists);
+
+        lists.clear();
+        for (auto &dirs : includeDirs) {
+            lists.emplace_back(&dirs);
+        }
+        writeConfigCommand(out, "target_include_directories", projectData.commonTarget,
+                           " INTERFACE", conditions, classes, lists);
+        appendf(out, "\n");
     }
 
-    fclose(pOut);
+    // Targets are written after their dependencies.
+    auto order = std::get<1>(topologicalOrder(projectData.dependencyGraph));
+    if (order.size() != projectData.targets.size()) {
+        // No graph was built, keep the original order.
+        order.resize(projectData.targets.size());
+        for (std::size_t i = 0; i < order.size(); ++i) {
+            order[i] = i;
+        }
+    }
+
+    std::set<std::string> subdirectories;
+    for (auto idx : order) {
+        generateCMakeProjectTarget(projectData.targets[idx], globalSettings, files, out,
+                                   subdirectories);
+    }
+}
+
+void generateCMakeProjectTarget(TargetData const &target,
+                                GlobalSettings const &globalSettings,
+                                GeneratedFiles &files,
+                                std::string &projectOut,
+                                std::set<std::string> &subdirectories) {
+    std::string &out = projectOut;
+    if (target.relativePath.find('/') == std::string::npos) {
+        // Put it in the same file, since it's in the same folder.
+        appendf(out, "\n\n# %s Target\n", target.name.data());
+        generateCMakeTarget(target, globalSettings, files, &out);
+        return;
+    }
+
+    generateCMakeTarget(target, globalSettings, files);
+    if (!subdirectories.insert(target.relativePath.substr(0, target.relativePath.find_last_of('/')))
+             .second) {
+        // Another target shares the directory, and its file.
+        return;
+    }
+    if (target.relativePath.find('"') != std::string::npos) {
+        // If the path has a space in it, surround with quotes.
+        appendf(out, "add_subdirectory( \"%s\" )\n",
+                target.relativePath.substr(0, target.relativePath.find_last_of('/')).data());
+    } else {
+        appendf(out, "add_subdirectory( %s )\n",
+                target.relativePath.substr(0, target.relativePath.find_last_of('/')).data());
+    }
 }
 
 void generateCMakeTarget(const TargetData &data,
                          GlobalSettings const &globalSettings,
-                         FILE *pOutfile) {
-    FILE *pOut = pOutfile;
+                         GeneratedFiles &files,
+                         std::string *pOutBuffer) {
+    std::string *pOut = pOutBuffer;
     if (pOut == nullptr) {
-        // Open own file.
+        // Own file.
         std::string outFilePath;
         auto lastSlash =
             std::min(data.fullPath.find_last_of('/'), data.fullPath.find_last_of('\\'));
@@ -218,39 +721,41 @@ void generateCMakeTarget(const TargetData &data,
             outFilePath = data.fullPath.substr(0, lastSlash);
         }
         outFilePath += cCmakeFilename;
-        pOut = fopen(outFilePath.c_str(), "w");
-        if (pOut == nullptr) {
-            printf("cmkizer: Failed to open file to send CMake output to - %s",
-                   outFilePath.c_str());
-            return;
+        pOut = &files[outFilePath];
+        if (pOut->empty()) {
+            appendf(*pOut, "cmake_minimum_required( VERSION %s )\n",
+                    globalSettings.cmakeVersion.data());
+        } else {
+            // Another target in the same directory was already written.
+            appendf(*pOut, "\n\n# %s Target\n", data.name.data());
         }
-        fprintf(pOut, "cmake_minimum_required( VERSION %s )\n", globalSettings.cmakeVersion.data());
     }
+    std::string &out = *pOut;
 
     // Project Name
     if (data.name.find(' ') == std::string::npos) {
         // Project name has no spaces
-        fprintf(pOut, "project ( %s )\n", data.name.data());
+        appendf(out, "project ( %s )\n", data.name.data());
     } else {
         // Project name has spaces
-        fprintf(pOut, "project ( \"%s\" )\n", data.name.data());
+        appendf(out, "project ( \"%s\" )\n", data.name.data());
     }
 
     // Languages
-    fprintf(pOut, "enable_language( ");
+    appendf(out, "enable_language( ");
     if (data.enableC) {
-        fprintf(pOut, "C ");
+        appendf(out, "C ");
     }
     if (data.enableCXX) {
-        fprintf(pOut, "CXX ");
+        appendf(out, "CXX ");
     }
     if (data.enableFortran) {
-        fprintf(pOut, "Fortran ");
+        appendf(out, "Fortran ");
     }
-    fprintf(pOut, ")\n");
+    appendf(out, ")\n");
 
     // File Sets
-    fprintf(pOut, "\n# File Sets");
+    appendf(out, "\n# File Sets");
     for (auto &[it, filter] : data.filters) {
         if (!filter.files.empty()) {
             std::string temp = it;
@@ -260,35 +765,66 @@ void generateCMakeTarget(const TargetData &data,
             std::transform(temp.begin(), temp.end(), temp.begin(),
                            [](unsigned char c) { return std::toupper(c); });
 
-            fprintf(pOut, "\nset(\n    %s\n", temp.data());
-            for (auto &it : filter.files) {
-                fprintf(pOut, "    %s\n", it.data());
+            appendf(out, "\nset(\n    %s\n", temp.data());
+            for (auto const &it : filter.files) {
+                appendf(out, "    %s\n", it.data());
             }
-            fprintf(pOut, ")\n");
+            appendf(out, ")\n");
         }
     }
 
     // Any extraneous files not part of a filter group
     if (!data.allFiles.empty()) {
-        fprintf(pOut, "\nset(\n    NON_FILTER_GROUP_FILES\n");
-        for (auto &it : data.allFiles) {
-            fprintf(pOut, "    %s\n", it.data());
+        appendf(out, "\nset(\n    NON_FILTER_GROUP_FILES\n");
+        for (auto const &it : data.allFiles) {
+            appendf(out, "    %s\n", it.data());
         }
-        fprintf(pOut, ")\n");
+        appendf(out, ")\n");
     }
 
     // QT
     if (data.useQt != 0) {
-        fprintf(pOut, "\n# Qt\n");
-        fprintf(pOut, "find_package(Qt%d REQUIRED)\n", globalSettings.qtVersion);
-        fprintf(pOut, "set(CMAKE_AUTOMOC ON)\n");
-        fprintf(pOut, "set(CMAKE_AUTOUIC ON)\n");
-        fprintf(pOut, "set(CMAKE_AUTORCC ON)\n");
-        fprintf(pOut, "set(CMAKE_INCLUDE_CURRENT_DIR ON)\n");
+        appendf(out, "\n# Qt\n");
+        // Qt5 unless told otherwise.
+        appendf(out, "find_package(Qt%d REQUIRED)\n",
+                (globalSettings.qtVersion != 0) ? globalSettings.qtVersion : 5);
+        appendf(out, "set(CMAKE_AUTOMOC ON)\n");
+        appendf(out, "set(CMAKE_AUTOUIC ON)\n");
+        appendf(out, "set(CMAKE_AUTORCC ON)\n");
+        appendf(out, "set(CMAKE_INCLUDE_CURRENT_DIR ON)\n");
     }
 
     // Source Groups
-    fprintf(pOut, "\n# Source Groups\n");
+    appendf(out, "\n# Source Groups\n");
+    for (auto &[it, filter] : data.filters) {
+        if (!filter.files.empty()) {
+            std::string temp(it);
+            std::replace(temp.begin(), temp.end(), ' ', '_');
+            std::replace(temp.begin(), temp.end(), '/', '_');
+            std::replace(temp.begin(), temp.end(), '\\', '_');
+            std::transform(temp.begin(), temp.end(), temp.begin(),
+                           [](unsigned char c) { return std::toupper(c); });
+
+            appendf(out, "source_group( \"%s\" FILES ${%s} )\n", it.data(), temp.data());
+        }
+    }
+
+    // MFC
+    if (data.useMFC == 6) {
+        appendf(out, "\nset(CMAKE_MFC_FLAG 2)\n");
+    } else if (data.useMFC != 0) {
+        appendf(out, "\nset(CMAKE_MFC_FLAG 1)\n");
+    }
+
+    // Target
+    appendf(out, "\n# Target\n");
+    if (data.isObjectLibrary) {
+        appendf(out, "add_library( %s OBJECT", data.name.data());
+    } else if (data.isLibrary) {
+        appendf(out, "add_library( %s", data.name.data());
+    } else {
+        appendf(out, "add_executable( %s", data.name.data());
+    }
     for (auto &[it, filter] : data.filters) {
         if (!filter.files.empty()) {
             std::string temp(it);
@@ -298,80 +834,194 @@ void generateCMakeTarget(const TargetData &data,
             std::transform(temp.begin(), temp.end(), temp.begin(),
                            [](unsigned char c) { return std::toupper(c); });
 
-            fprintf(pOut, "source_group( \"%s\" FILES ${%s} )\n", it.data(), temp.data());
+            appendf(out, " ${%s}", temp.data());
         }
     }
+    appendf(out, " )\n");
+    if (data.positionIndependent) {
+        appendf(out, "set_target_properties( %s PROPERTIES POSITION_INDEPENDENT_CODE ON )\n",
+                data.name.data());
+    }
 
-    // Configurations
+    // Configurations, with the differences between them as generator expressions.
+    // Configurations sharing an instance have identical settings, so the work
+    // below is done once per class of them.
+    std::vector<std::string> configNames;
+    std::vector<std::vector<std::size_t>> classes;
+    std::vector<TargetConfig const *> classConfigs;
     for (auto &[name, config] : data.configs) {
-        fprintf(pOut, "\n# Configuration - %s\n", name.data());
-        fprintf(pOut, "if()\n");
-        // MFC
-        if (data.useMFC == 6) {
-            fprintf(pOut, "    set(CMAKE_MFC_FLAG 2)\n");
-        } else if (data.useMFC != 0) {
-            fprintf(pOut, "    set(CMAKE_MFC_FLAG 1)\n");
-        }
-
-        // Target
-        if (data.isLibrary) {
-            fprintf(pOut, "    add_library( %s", data.name.data());
-        } else {
-            fprintf(pOut, "    add_executable( %s", data.name.data());
-        }
-        for (auto &[it, filter] : data.filters) {
-            if (!filter.files.empty()) {
-                std::string temp(it);
-                std::replace(temp.begin(), temp.end(), ' ', '_');
-                std::replace(temp.begin(), temp.end(), '/', '_');
-                std::replace(temp.begin(), temp.end(), '\\', '_');
-                std::transform(temp.begin(), temp.end(), temp.begin(),
-                               [](unsigned char c) { return std::toupper(c); });
-
-                fprintf(pOut, " ${%s}", temp.data());
-            }
+        std::size_t classIdx = 0;
+        while (classIdx < classConfigs.size() && classConfigs[classIdx] != &*config) {
+            ++classIdx;
+        }
+        if (classIdx == classConfigs.size()) {
+            classConfigs.emplace_back(&*config);
+            classes.emplace_back();
+        }
+        classes[classIdx].emplace_back(configNames.size());
+        configNames.emplace_back(name);
+    }
+    auto const conditions = configConditions(configNames);
+
+    auto writeSetting = [&](char const *command, char const *scope,
+                            std::vector<std::string> TargetConfig::*member) {
+        std::vector<std::vector<std::string> const *> lists;
+        for (auto const *config : classConfigs) {
+            lists.emplace_back(&(config->*member));
         }
-        fprintf(pOut, " )\n");
+        writeConfigCommand(out, command, data.name, scope, conditions, classes, lists);
+    };
+    writeSetting("target_compile_definitions", " PRIVATE", &TargetConfig::definitions);
+    writeSetting("target_include_directories", " PRIVATE", &TargetConfig::includeDirs);
+    writeSetting("target_link_libraries", "", &TargetConfig::linkLibraries);
+    writeSetting("target_link_directories", " PRIVATE", &TargetConfig::linkDirs);
 
-        // Definitions
-        if (!config.definitions.empty()) {
-            fprintf(pOut, "    target_compile_definitions( %s", data.name.data());
-            for (auto &def : config.definitions) {
-                fprintf(pOut, " %s", def.data());
+    // Precompiled Headers
+    std::vector<std::vector<std::string>> pchHeaders;
+    bool usePch = false;
+    for (auto const *config : classConfigs) {
+        auto &headers = pchHeaders.emplace_back();
+        if (config->precompiledHeader.empty()) {
+            continue;
+        }
+        usePch = true;
+        headers.emplace_back(precompiledHeaderFile(data, *config));
+    }
+    if (usePch) {
+        std::vector<std::vector<std::string> const *> lists;
+        for (auto &headers : pchHeaders) {
+            lists.emplace_back(&headers);
+        }
+        appendf(out, "if(COMMAND target_precompile_headers)\n    ");
+        writeConfigCommand(out, "target_precompile_headers", data.name, " PRIVATE", conditions,
+                           classes, lists);
+        appendf(out, "endif()\n");
+    }
+    if (!usePch && !data.precompileHeaders.empty()) {
+        // Only the C++ sources use them, if there are also C sources.
+        bool const cxxOnly = data.enableC && data.enableCXX;
+        appendf(out, "if(COMMAND target_precompile_headers)\n");
+        appendf(out, "    target_precompile_headers( %s PRIVATE", data.name.data());
+        for (auto const &header : data.precompileHeaders) {
+            std::string item = header;
+            if (item.front() != '<') {
+                item = "${CMAKE_CURRENT_SOURCE_DIR}/" + item;
+            } else if (cxxOnly) {
+                item.replace(item.size() - 1, 1, "$<ANGLE-R>");
+            }
+            if (cxxOnly) {
+                appendf(out, " \"$<$<COMPILE_LANGUAGE:CXX>:%s>\"", item.data());
+            } else {
+                appendf(out, " %s", item.data());
             }
-            fprintf(pOut, " )\n");
         }
+        appendf(out, " )\nendif()\n");
+    }
 
-        // Includes
-        if (!config.includeDirs.empty()) {
-            fprintf(pOut, "    target_include_directories( %s", data.name.data());
-            for (auto &inc : config.includeDirs) {
-                fprintf(pOut, " %s", inc.data());
+    // Unity Build, grouped by source size, groups need CMake 3.18
+    if (!data.unityGroups.empty()) {
+        appendf(out, "if(NOT CMAKE_VERSION VERSION_LESS 3.18)\n");
+        appendf(out,
+                "    set_target_properties( %s PROPERTIES UNITY_BUILD ON UNITY_BUILD_MODE GROUP"
+                " )\n",
+                data.name.data());
+        for (std::size_t i = 0; i < data.unityGroups.size(); ++i) {
+            appendf(out, "    set_source_files_properties(");
+            for (auto const &file : data.unityGroups[i]) {
+                appendf(out, " %s", file.data());
             }
-            fprintf(pOut, " )\n");
+            appendf(out, " PROPERTIES UNITY_GROUP %s_%zu )\n", data.name.data(), i + 1);
         }
+        appendf(out, "endif()\n");
+    }
 
-        // Libraries
-        if (!config.linkLibraries.empty()) {
-            fprintf(pOut, "    target_link_libraries( %s", data.name.data());
-            for (auto &lib : config.linkLibraries) {
-                fprintf(pOut, " %s", lib.data());
-            }
-            fprintf(pOut, " )\n");
+    // Whole Program Optimization, enabled for a build type when all its configs use it
+    std::map<std::string, bool> ipoTypes;
+    for (auto &[name, config] : data.configs) {
+        auto [it, inserted] = ipoTypes.try_emplace(buildType(name), true);
+        it->second = it->second && config->wholeProgramOptimization;
+    }
+    for (auto &[type, enabled] : ipoTypes) {
+        if (enabled) {
+            std::string upperType = type;
+            std::transform(upperType.begin(), upperType.end(), upperType.begin(), ::toupper);
+            appendf(out,
+                    "set_property( TARGET %s PROPERTY INTERPROCEDURAL_OPTIMIZATION_%s ON )\n",
+                    data.name.data(), upperType.data());
         }
+    }
 
-        if (!config.linkDirs.empty()) {
-            fprintf(pOut, "    target_link_directories( %s", data.name.data());
-            for (auto &dir : config.linkDirs) {
-                fprintf(pOut, " %s", dir.data());
+    // Optimization Options
+    std::vector<std::vector<std::string>> msvcOptions;
+    std::vector<std::vector<std::string>> otherOptions;
+    bool anyMsvc = false;
+    bool anyOther = false;
+    for (auto const *config : classConfigs) {
+        anyMsvc = !msvcOptions.emplace_back(performanceOptions(*config, true)).empty() || anyMsvc;
+        anyOther =
+            !otherOptions.emplace_back(performanceOptions(*config, false)).empty() || anyOther;
+    }
+    if (anyMsvc) {
+        std::vector<std::vector<std::string> const *> lists;
+        for (auto &options : msvcOptions) {
+            lists.emplace_back(&options);
+        }
+        appendf(out, "if(MSVC)\n    ");
+        writeConfigCommand(out, "target_compile_options", data.name, " PRIVATE", conditions,
+                           classes, lists);
+        if (anyOther) {
+            lists.clear();
+            for (auto &options : otherOptions) {
+                lists.emplace_back(&options);
             }
-            fprintf(pOut, " )\n");
+            appendf(out, "else()\n    ");
+            writeConfigCommand(out, "target_compile_options", data.name, " PRIVATE",
+                               conditions, classes, lists);
+        }
+        appendf(out, "endif()\n");
+    }
+}
+
+bool writeGeneratedFile(std::string const &filePath,
+                        std::string_view contents,
+                        std::vector<std::string> &diagnostics,
+                        std::string_view outputDir,
+                        std::string_view baseDir,
+                        bool append) {
+    std::string path = filePath;
+    if (!outputDir.empty()) {
+        auto [inside, outputPath] = outputFilePath(filePath, outputDir, baseDir);
+        if (!inside) {
+            diagnostics.emplace_back("Error: Generated file is outside of the output directory, "
+                                     "not written - " +
+                                     filePath);
+            return false;
         }
+        path = std::move(outputPath);
+        std::error_code error;
+        std::filesystem::create_directories(std::filesystem::path(path).parent_path(), error);
+    }
 
-        fprintf(pOut, "endif()\n");
+    FILE *pOut = fopen(path.c_str(), append ? "a" : "w");
+    if (pOut == nullptr) {
+        diagnostics.emplace_back("cmkizer: Failed to open file to send CMake output to - " + path);
+        return false;
     }
+    fwrite(contents.data(), 1, contents.size(), pOut);
+    fclose(pOut);
+    return true;
+}
 
-    if (pOutfile == nullptr) {
-        fclose(pOut);
+bool writeGeneratedFiles(GeneratedFiles const &files,
+                         std::vector<std::string> &diagnostics,
+                         std::string_view outputDir,
+                         std::string_view baseDir) {
+    bool success = true;
+
+    for (auto const &[filePath, contents] : files) {
+        success =
+            writeGeneratedFile(filePath, contents, diagnostics, outputDir, baseDir) && success;
     }
-}
\ No newline at end of file
+
+    return success;
+}
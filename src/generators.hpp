@@ -30,26 +30,107 @@
 #include "type_defs.hpp"
 
 // C++
+#include <map>
+#include <set>
 #include <string>
+#include <string_view>
+#include <vector>
+
+/// Returns the directory of a target, relative to the project's path.
+std::string targetDirectory(TargetData const &target);
+
+/// Determines the CMake build type a MSVS configuration name maps to, such as
+/// 'Debug' for both 'Debug|Win32' and 'target - Win32 Debug'.
+std::string buildType(std::string_view configName);
+
+/// Picks the configuration of a target to use with generators that only handle
+/// one, by its full name or otherwise by its build type, case-insensitively.
+/// \param target The target to pick from.
+/// \param name The configuration to pick, empty for the target's first one.
+/// \return The name and configuration, or the end of the target's configs if
+/// there is no such configuration.
+std::map<std::string, SharedConfig>::const_iterator selectConfig(TargetData const &target,
+                                                                 std::string_view name);
+
+/// Translates a config's build performance settings into compiler options.
+/// \param msvc If true, MSVC style options are given, otherwise GCC/Clang style.
+std::vector<std::string> performanceOptions(TargetConfig const &config, bool msvc);
+
+/// Finds the precompiled header of a config, preferring the header's location
+/// within the target if it is listed there.
+/// \return The header as listed by the target, otherwise as named by the
+/// config, or empty if the config uses none.
+std::string precompiledHeaderFile(TargetData const &target, TargetConfig const &config);
+
+/// Preprocesses a single target's data, cleaning up the parsed settings and
+/// paths, without regard to the rest of the project.
+/// \param target The TargetData to process.
+void preprocessTarget(TargetData &target);
 
 /// Preprocesses a project's data to fill in any gaps/holes in data as best as
 /// can be guessed, aswell as links up dependencies between targets.
 /// \param data The ProjectData to process.
 /// \return A processed ProjectData struct.
-ProjectData projectPreprocessing(ProjectData data, GlobalSettings &globalSettings);
+ProjectData projectPreprocessing(ProjectData data);
 
 /// Generates a CMake file using the provided project data
 /// \param projectData The data to use to construct the CMake file.
-void generateCMakeProject(const ProjectData &projectData, GlobalSettings const &globalSettings);
+/// \param files Receives the generated files.
+void generateCMakeProject(const ProjectData &projectData,
+                          GlobalSettings const &globalSettings,
+                          GeneratedFiles &files);
+
+/// Generates a target as part of a project, appending it to the project's own
+/// file if it shares the project's directory, or giving it its own file and
+/// adding that directory to the project's file otherwise.
+/// \param target The TargetData to use.
+/// \param files Receives the target's file, if it has its own.
+/// \param projectOut The contents of the project's file, appended to.
+/// \param subdirectories The directories already added to the project's file.
+void generateCMakeProjectTarget(TargetData const &target,
+                                GlobalSettings const &globalSettings,
+                                GeneratedFiles &files,
+                                std::string &projectOut,
+                                std::set<std::string> &subdirectories);
 
 /// Generates a CMake file using the provided target data.
 /// \param data The TargetData to use.
-/// \param standalone If true, then the target is written as if a standalone
-/// project/target combination.
-/// \param pOutfile If specified, then this will be file the output is written
-/// to.
+/// \param files Receives the generated file, if pOutBuffer is not given.
+/// \param pOutBuffer If specified, then the target is appended to this rather
+/// than being written as its own file.
 void generateCMakeTarget(const TargetData &data,
                          GlobalSettings const &globalSettings,
-                         FILE *pOutfile = nullptr);
+                         GeneratedFiles &files,
+                         std::string *pOutBuffer = nullptr);
+
+/// Writes a single generated file out to disk.
+/// \param filePath The path of the file.
+/// \param contents The contents to write.
+/// \param diagnostics Receives a message if the file could not be written.
+/// \param outputDir If set, the file is written to this directory, which is
+/// created along with any missing subdirectories, at its path relative to
+/// baseDir. A file that would end up outside of it is not written.
+/// \param baseDir The directory of the converted input.
+/// \param append If true, the contents are added to the end of an existing file.
+/// \return True if the file was written.
+bool writeGeneratedFile(std::string const &filePath,
+                        std::string_view contents,
+                        std::vector<std::string> &diagnostics,
+                        std::string_view outputDir = {},
+                        std::string_view baseDir = {},
+                        bool append = false);
+
+/// Writes generated files out to disk.
+/// \param files The files to write.
+/// \param diagnostics Receives a message for each file that could not be written.
+/// \param outputDir If set, the files are written to this directory, which is
+/// created along with any missing subdirectories, at their paths relative to
+/// baseDir. Files that would end up outside of it are not written.
+/// \param baseDir The directory of the converted input.
+/// \return True if all files were written.
+bool writeGeneratedFiles(GeneratedFiles const &files,
+                         std::vector<std::string> &diagnostics,
+                         std::string_view outputDir = {},
+                         std::string_view baseDir = {});
 
 #endif // GENERATORS_HPP
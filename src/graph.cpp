@@ -0,0 +1,247 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2018 George Cave <gcave@stablecoder.ca>
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ */
+
+#include "graph.hpp"
+
+// C++
+#include <algorithm>
+#include <cctype>
+#include <unordered_map>
+
+DependencyGraph buildDependencyGraph(ProjectData const &data) {
+    DependencyGraph graph;
+    graph.dependencies.resize(data.targets.size());
+    graph.dependents.resize(data.targets.size());
+
+    auto toUpper = [](std::string str) {
+        std::transform(str.begin(), str.end(), str.begin(), ::toupper);
+        return str;
+    };
+
+    // First target with a given name wins, as with a linear search.
+    std::unordered_map<std::string, std::size_t> nameIndices;
+    for (std::size_t i = 0; i < data.targets.size(); ++i) {
+        nameIndices.try_emplace(toUpper(data.targets[i].displayName), i);
+    }
+
+    for (std::size_t i = 0; i < data.targets.size(); ++i) {
+        auto &dependencies = graph.dependencies[i];
+
+        for (auto const &dependency : data.targets[i].dependencies) {
+            auto it = nameIndices.find(toUpper(dependency));
+            if (it == nameIndices.end()) {
+                continue;
+            }
+            if (std::find(dependencies.begin(), dependencies.end(), it->second) ==
+                dependencies.end()) {
+                dependencies.emplace_back(it->second);
+                graph.dependents[it->second].emplace_back(i);
+            }
+        }
+    }
+
+    return graph;
+}
+
+std::tuple<bool, std::vector<std::size_t>> topologicalOrder(DependencyGraph const &graph) {
+    auto const count = graph.dependencies.size();
+    std::vector<std::size_t> order;
+    order.reserve(count);
+
+    // Kahn's algorithm, seeded in the original order to keep the output stable.
+    std::vector<std::size_t> remaining(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        remaining[i] = graph.dependencies[i].size();
+        if (remaining[i] == 0) {
+            order.emplace_back(i);
+        }
+    }
+    for (std::size_t next = 0; next < order.size(); ++next) {
+        for (auto dependent : graph.dependents[order[next]]) {
+            if (--remaining[dependent] == 0) {
+                order.emplace_back(dependent);
+            }
+        }
+    }
+
+    if (order.size() == count) {
+        return std::make_tuple(true, order);
+    }
+
+    for (std::size_t i = 0; i < count; ++i) {
+        if (remaining[i] != 0) {
+            order.emplace_back(i);
+        }
+    }
+    return std::make_tuple(false, order);
+}
+
+std::vector<std::vector<std::size_t>> levelSets(DependencyGraph const &graph) {
+    auto const count = graph.dependencies.size();
+    std::vector<std::vector<std::size_t>> levels;
+    std::vector<std::size_t> level(count, 0);
+    std::vector<std::size_t> remaining(count);
+    std::vector<std::size_t> queue;
+    queue.reserve(count);
+
+    for (std::size_t i = 0; i < count; ++i) {
+        remaining[i] = graph.dependencies[i].size();
+        if (remaining[i] == 0) {
+            queue.emplace_back(i);
+        }
+    }
+    for (std::size_t next = 0; next < queue.size(); ++next) {
+        auto const node = queue[next];
+        if (levels.size() <= level[node]) {
+            levels.resize(level[node] + 1);
+        }
+        levels[level[node]].emplace_back(node);
+
+        for (auto dependent : graph.dependents[node]) {
+            level[dependent] = std::max(level[dependent], level[node] + 1);
+            if (--remaining[dependent] == 0) {
+                queue.emplace_back(dependent);
+            }
+        }
+    }
+
+    if (queue.size() != count) {
+        auto &cyclic = levels.emplace_back();
+        for (std::size_t i = 0; i < count; ++i) {
+            if (remaining[i] != 0) {
+                cyclic.emplace_back(i);
+            }
+        }
+    }
+
+    return levels;
+}
+
+std::vector<std::vector<std::size_t>> findCycles(DependencyGraph const &graph) {
+    auto const count = graph.dependencies.size();
+    constexpr auto cUnvisited = static_cast<std::size_t>(-1);
+
+    // Iterative Tarjan's strongly connected components.
+    std::vector<std::size_t> index(count, cUnvisited);
+    std::vector<std::size_t> lowLink(count, 0);
+    std::vector<std::size_t> component(count, cUnvisited);
+    std::vector<bool> onStack(count, false);
+    std::vector<std::size_t> stack;
+    std::vector<std::pair<std::size_t, std::size_t>> callStack;
+    std::size_t nextIndex = 0;
+    std::size_t componentCount = 0;
+    std::vector<std::size_t> cyclicComponents;
+
+    for (std::size_t root = 0; root < count; ++root) {
+        if (index[root] != cUnvisited) {
+            continue;
+        }
+        callStack.emplace_back(root, 0);
+
+        while (!callStack.empty()) {
+            auto &[node, edge] = callStack.back();
+            if (edge == 0) {
+                index[node] = lowLink[node] = nextIndex++;
+                stack.emplace_back(node);
+                onStack[node] = true;
+            }
+
+            auto const &edges = graph.dependencies[node];
+            if (edge < edges.size()) {
+                auto const next = edges[edge++];
+                if (index[next] == cUnvisited) {
+                    callStack.emplace_back(next, 0);
+                } else if (onStack[next]) {
+                    lowLink[node] = std::min(lowLink[node], index[next]);
+                }
+                continue;
+            }
+
+            auto const finished = node;
+            callStack.pop_back();
+            if (!callStack.empty()) {
+                auto const parent = callStack.back().first;
+                lowLink[parent] = std::min(lowLink[parent], lowLink[finished]);
+            }
+
+            if (lowLink[finished] == index[finished]) {
+                std::size_t size = 0;
+                std::size_t member;
+                do {
+                    member = stack.back();
+                    stack.pop_back();
+                    onStack[member] = false;
+                    component[member] = componentCount;
+                    ++size;
+                } while (member != finished);
+
+                auto const &selfEdges = graph.dependencies[finished];
+                if (size > 1 ||
+                    std::find(selfEdges.begin(), selfEdges.end(), finished) != selfEdges.end()) {
+                    cyclicComponents.emplace_back(finished);
+                }
+                ++componentCount;
+            }
+        }
+    }
+
+    // Walk each cyclic component from one of its members until a target repeats.
+    std::vector<std::vector<std::size_t>> cycles;
+    std::vector<std::size_t> position(count, cUnvisited);
+    for (auto start : cyclicComponents) {
+        std::vector<std::size_t> path;
+        auto node = start;
+        while (position[node] == cUnvisited) {
+            position[node] = path.size();
+            path.emplace_back(node);
+            for (auto next : graph.dependencies[node]) {
+                if (component[next] == component[start]) {
+                    node = next;
+                    break;
+                }
+            }
+        }
+
+        std::vector<std::size_t> cycle(path.begin() + position[node], path.end());
+        cycle.emplace_back(node);
+        for (auto member : path) {
+            position[member] = cUnvisited;
+        }
+        cycles.emplace_back(std::move(cycle));
+    }
+
+    return cycles;
+}
+
+std::string describeCycle(ProjectData const &data, std::vector<std::size_t> const &cycle) {
+    std::string description;
+    for (auto idx : cycle) {
+        if (!description.empty()) {
+            description += " -> ";
+        }
+        description += data.targets[idx].name;
+    }
+    return description;
+}
@@ -0,0 +1,68 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2018 George Cave <gcave@stablecoder.ca>
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ */
+
+#ifndef GRAPH_HPP
+#define GRAPH_HPP
+
+// cmkizer
+#include "type_defs.hpp"
+
+// C++
+#include <string>
+#include <tuple>
+#include <vector>
+
+/// Builds the dependency graph of a project, resolving each target's
+/// dependencies against the display names of the other targets.
+/// \param data The project whose targets to link up.
+/// \return The graph, with an entry for every target.
+DependencyGraph buildDependencyGraph(ProjectData const &data);
+
+/// Orders the targets such that every target comes after its dependencies.
+/// \param graph The graph to order.
+/// \return A boolean that is false if there are cycles, and the order. Targets
+/// that are part of or depend upon a cycle are placed last, in their original
+/// order.
+std::tuple<bool, std::vector<std::size_t>> topologicalOrder(DependencyGraph const &graph);
+
+/// Groups the targets into levels, where every target only depends upon
+/// targets of earlier levels, so each level can be processed in parallel.
+/// Targets that are part of or depend upon a cycle are put into a final level.
+/// \param graph The graph to group.
+/// \return The targets of each level.
+std::vector<std::vector<std::size_t>> levelSets(DependencyGraph const &graph);
+
+/// Finds the dependency cycles within the graph.
+/// \param graph The graph to search.
+/// \return One cycle per strongly connected group of targets, as the sequence
+/// of targets walked before returning to the first.
+std::vector<std::vector<std::size_t>> findCycles(DependencyGraph const &graph);
+
+/// Describes a cycle in a readable form, such as 'a -> b -> a'.
+/// \param data The project the cycle is within.
+/// \param cycle The cycle, as returned by findCycles.
+std::string describeCycle(ProjectData const &data, std::vector<std::size_t> const &cycle);
+
+#endif // GRAPH_HPP
@@ -0,0 +1,640 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2018 George Cave <gcave@stablecoder.ca>
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ */
+
+#include "include_scan.hpp"
+
+// cmkizer
+#include "config_pool.hpp"
+#include "parallel.hpp"
+#include "prefetch.hpp"
+#include "util.hpp"
+
+// C++
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <tuple>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace {
+
+/// A rough rate at which a compiler front end gets through header text, to
+/// estimate the time saved by precompiling.
+constexpr double cHeaderBytesPerSecond = 2.0 * 1024 * 1024;
+
+std::string foldCase(std::string str) {
+    std::transform(str.begin(), str.end(), str.begin(), ::tolower);
+    return str;
+}
+
+/// Normalizes a path, without any trailing slash.
+std::string normalPath(std::filesystem::path const &path) {
+    std::string retVal = path.lexically_normal().generic_string();
+    if (retVal.size() > 1 && retVal.back() == '/') {
+        retVal.pop_back();
+    }
+    return retVal;
+}
+
+/// The files beneath a set of root directories, to look paths up in without
+/// going back to the filesystem. Lookups ignore case, as the projects come
+/// from case-insensitive filesystems.
+class DirectoryIndex {
+  public:
+    /// Indexes the files beneath a directory, skipping hidden and symlinked
+    /// directories.
+    void add(std::string const &root) {
+        std::error_code error;
+        std::filesystem::recursive_directory_iterator it(
+            root, std::filesystem::directory_options::skip_permission_denied, error);
+        for (; !error && it != std::filesystem::recursive_directory_iterator();
+             it.increment(error)) {
+            auto const name = it->path().filename().string();
+            if (it->is_directory(error)) {
+                if (name.front() == '.' || it->is_symlink(error)) {
+                    it.disable_recursion_pending();
+                }
+                continue;
+            }
+            if (!it->is_regular_file(error)) {
+                continue;
+            }
+
+            auto const path = normalPath(it->path());
+            if (files.try_emplace(foldCase(path), path).second) {
+                auto const directory = path.substr(0, path.find_last_of('/'));
+                nameDirs[foldCase(name)].emplace_back(directory);
+            }
+        }
+    }
+
+    /// \return The path of an indexed file as found on disk, or nullptr.
+    std::string const *find(std::string const &path) const {
+        auto it = files.find(foldCase(path));
+        return (it != files.end()) ? &it->second : nullptr;
+    }
+
+    /// \return The directories holding a file of the given name, or nullptr.
+    std::vector<std::string> const *directoriesWith(std::string const &name) const {
+        auto it = nameDirs.find(foldCase(name));
+        return (it != nameDirs.end()) ? &it->second : nullptr;
+    }
+
+  private:
+    /// Case-folded path to the path on disk
+    std::unordered_map<std::string, std::string> files;
+    /// Case-folded file name to the directories holding it
+    std::unordered_map<std::string, std::vector<std::string>> nameDirs;
+};
+
+/// The progress of inferring a single target's include directories.
+struct TargetScan {
+    /// The target's directory
+    std::string directory;
+    /// The directories searched for includes, existing ones then added ones
+    std::vector<std::string> includeDirs;
+    std::size_t existingCount{0};
+    /// Case-folded paths of the files already queued
+    std::unordered_set<std::string> seen;
+    /// Files whose includes are to be resolved next
+    std::vector<std::string> pending;
+};
+
+/// Counts the characters two paths share from the start, up to the last
+/// directory separator.
+std::size_t commonPrefix(std::string const &lhs, std::string const &rhs) {
+    std::size_t common = 0;
+    for (std::size_t i = 0; i < std::min(lhs.size(), rhs.size()) && lhs[i] == rhs[i]; ++i) {
+        if (lhs[i] == '/') {
+            common = i;
+        }
+    }
+    return common;
+}
+
+/// Resolves the includes of a target's pending files, adding the fewest
+/// directories needed for those that don't resolve, and queues the files they
+/// resolve to.
+void resolveTarget(TargetScan &scan,
+                   DirectoryIndex const &index,
+                   std::unordered_map<std::string, std::vector<std::string>> const &includeCache) {
+    auto queue = [&](std::string const &path, std::vector<std::string> &next) {
+        if (scan.seen.insert(foldCase(path)).second) {
+            next.emplace_back(path);
+        }
+    };
+    auto resolve = [&](std::string const &directory, std::string const &include,
+                       std::vector<std::string> &next) {
+        if (auto const *found = index.find(normalPath(directory + '/' + include))) {
+            queue(*found, next);
+            return true;
+        }
+        return false;
+    };
+
+    // Includes that resolve against nothing so far, and the directories that
+    // would resolve each of them.
+    std::vector<std::string> unresolved;
+    std::vector<std::vector<std::string>> candidates;
+
+    std::vector<std::string> next;
+    for (auto const &file : scan.pending) {
+        auto cached = includeCache.find(foldCase(file));
+        if (cached == includeCache.end()) {
+            continue;
+        }
+        auto const fileDir = file.substr(0, file.find_last_of('/'));
+        for (auto const &include : cached->second) {
+            if (isAbsolutePath(include) || resolve(fileDir, include, next)) {
+                continue;
+            }
+            bool found = false;
+            for (auto const &includeDir : scan.includeDirs) {
+                if (resolve(includeDir, include, next)) {
+                    found = true;
+                    break;
+                }
+            }
+            if (found || std::find(unresolved.begin(), unresolved.end(), include) !=
+                             unresolved.end()) {
+                continue;
+            }
+
+            // A directory holding the file, with the include's own
+            // directories trimmed off, would resolve it.
+            auto const lastSlash = include.find_last_of('/');
+            auto const name = include.substr(lastSlash + 1);
+            std::string subdir;
+            if (lastSlash != std::string::npos) {
+                subdir = '/' + include.substr(0, lastSlash);
+            }
+            auto const *directories = index.directoriesWith(name);
+            if (directories == nullptr) {
+                continue;
+            }
+            std::vector<std::string> resolving;
+            for (auto const &directory : *directories) {
+                if (directory.size() > subdir.size() &&
+                    foldCase(directory.substr(directory.size() - subdir.size())) ==
+                        foldCase(subdir)) {
+                    resolving.emplace_back(directory.substr(0, directory.size() - subdir.size()));
+                }
+            }
+            if (!resolving.empty()) {
+                unresolved.emplace_back(include);
+                candidates.emplace_back(std::move(resolving));
+            }
+        }
+    }
+
+    // Greedily pick the directory resolving the most remaining includes, the
+    // closest to the target when tied.
+    std::vector<bool> covered(unresolved.size(), false);
+    while (true) {
+        std::unordered_map<std::string, std::size_t> counts;
+        for (std::size_t i = 0; i < unresolved.size(); ++i) {
+            if (!covered[i]) {
+                for (auto const &directory : candidates[i]) {
+                    ++counts[directory];
+                }
+            }
+        }
+        if (counts.empty()) {
+            break;
+        }
+
+        auto best = counts.begin();
+        for (auto it = counts.begin(); it != counts.end(); ++it) {
+            auto const closeness = commonPrefix(it->first, scan.directory);
+            auto const bestCloseness = commonPrefix(best->first, scan.directory);
+            if (std::tie(it->second, closeness) > std::tie(best->second, bestCloseness) ||
+                (std::tie(it->second, closeness) == std::tie(best->second, bestCloseness) &&
+                 it->first < best->first)) {
+                best = it;
+            }
+        }
+
+        auto const chosen = best->first;
+        scan.includeDirs.emplace_back(chosen);
+        for (std::size_t i = 0; i < unresolved.size(); ++i) {
+            if (!covered[i] &&
+                std::find(candidates[i].begin(), candidates[i].end(), chosen) !=
+                    candidates[i].end()) {
+                covered[i] = true;
+                resolve(chosen, unresolved[i], next);
+            }
+        }
+    }
+
+    scan.pending = std::move(next);
+}
+
+/// Sets up the scan of each target, with the include directories it already
+/// has, and indexes the files beneath the project and any target outside it.
+void prepareScans(ProjectData const &data, std::vector<TargetScan> &scans, DirectoryIndex &index) {
+    std::error_code error;
+    auto absoluteDir = [&](std::string const &path) {
+        auto const parent = std::filesystem::path(path).parent_path();
+        return normalPath(std::filesystem::absolute(parent.empty() ? "." : parent, error));
+    };
+
+    // The files beneath the project, and beneath any target outside of it.
+    std::vector<std::string> roots{
+        absoluteDir(data.path.empty() ? data.targets[0].fullPath : data.path)};
+    for (std::size_t i = 0; i < data.targets.size(); ++i) {
+        auto const &target = data.targets[i];
+        auto &scan = scans[i];
+        scan.directory = absoluteDir(target.fullPath);
+
+        if (std::none_of(roots.begin(), roots.end(), [&](std::string const &root) {
+                return scan.directory.compare(0, root.size(), root) == 0 &&
+                       (scan.directory.size() == root.size() ||
+                        scan.directory[root.size()] == '/');
+            })) {
+            roots.emplace_back(scan.directory);
+        }
+
+        auto addExisting = [&](std::string const &baseDir, std::string const &includeDir) {
+            if (includeDir.find("$(") != std::string::npos) {
+                return;
+            }
+            auto const path = isAbsolutePath(includeDir) ? normalPath(includeDir)
+                                                         : normalPath(baseDir + '/' + includeDir);
+            if (std::find(scan.includeDirs.begin(), scan.includeDirs.end(), path) ==
+                scan.includeDirs.end()) {
+                scan.includeDirs.emplace_back(path);
+            }
+        };
+        for (auto const &[name, config] : target.configs) {
+            for (auto const &includeDir : config->includeDirs) {
+                addExisting(scan.directory, includeDir);
+            }
+
+            // Those hoisted into the common target are relative to the project.
+            auto const &linked = config->linkLibraries;
+            auto common = data.commonConfigs.find(name);
+            if (!data.commonTarget.empty() && common != data.commonConfigs.end() &&
+                std::find(linked.begin(), linked.end(), data.commonTarget) != linked.end()) {
+                for (auto const &includeDir : common->second.includeDirs) {
+                    addExisting(roots[0], includeDir);
+                }
+            }
+        }
+        scan.existingCount = scan.includeDirs.size();
+    }
+    for (auto const &root : roots) {
+        index.add(root);
+    }
+}
+
+} // namespace
+
+void extractIncludes(std::string_view text,
+                     std::vector<std::string> &includes,
+                     std::vector<std::string> *pAngled) {
+    char const *const begin = text.data();
+    char const *const end = begin + text.size();
+    auto skipBlanks = [&](char const *pos) {
+        while (pos != end && (*pos == ' ' || *pos == '\t')) {
+            ++pos;
+        }
+        return pos;
+    };
+
+    char const *pos = begin;
+    while (pos != end) {
+        auto const *hash = static_cast<char const *>(std::memchr(pos, '#', end - pos));
+        if (hash == nullptr) {
+            break;
+        }
+        pos = hash + 1;
+
+        // Only blanks may come before the directive on its line.
+        char const *lineStart = hash;
+        while (lineStart != begin && (lineStart[-1] == ' ' || lineStart[-1] == '\t')) {
+            --lineStart;
+        }
+        if (lineStart != begin && lineStart[-1] != '\n') {
+            continue;
+        }
+
+        auto const *directive = skipBlanks(pos);
+        if (end - directive < 7 || std::memcmp(directive, "include", 7) != 0) {
+            continue;
+        }
+        auto const *open = skipBlanks(directive + 7);
+        if (open == end || (*open != '"' && (*open != '<' || pAngled == nullptr))) {
+            continue;
+        }
+        char const closing = (*open == '"') ? '"' : '>';
+        auto const remaining = static_cast<std::size_t>(end - open - 1);
+        auto const *close = static_cast<char const *>(std::memchr(open + 1, closing, remaining));
+        auto const *newline = static_cast<char const *>(std::memchr(open + 1, '\n', remaining));
+        if (close == nullptr || (newline != nullptr && newline < close)) {
+            continue;
+        }
+
+        auto &include = (closing == '"' ? includes : *pAngled).emplace_back(open + 1, close);
+        std::replace(include.begin(), include.end(), '\\', '/');
+        pos = close + 1;
+    }
+}
+
+std::size_t inferIncludeDirs(ProjectData &data, unsigned threadCount) {
+    if (data.targets.empty()) {
+        return 0;
+    }
+
+    std::vector<TargetScan> scans(data.targets.size());
+    DirectoryIndex index;
+    prepareScans(data, scans, index);
+
+    for (std::size_t i = 0; i < data.targets.size(); ++i) {
+        auto &scan = scans[i];
+        for (auto const &[name, filter] : data.targets[i].filters) {
+            for (auto const &file : filter.files) {
+                if (isAbsolutePath(file)) {
+                    continue;
+                }
+                if (auto const *found = index.find(normalPath(scan.directory + '/' + file))) {
+                    if (scan.seen.insert(foldCase(*found)).second) {
+                        scan.pending.emplace_back(*found);
+                    }
+                }
+            }
+        }
+    }
+
+    // In waves, every file not yet scanned is read and scanned in parallel,
+    // then each target resolves what its files include.
+    std::unordered_map<std::string, std::vector<std::string>> includeCache;
+    while (std::any_of(scans.begin(), scans.end(),
+                       [](TargetScan const &scan) { return !scan.pending.empty(); })) {
+        std::vector<std::string> paths;
+        std::unordered_set<std::string> queued;
+        for (auto const &scan : scans) {
+            for (auto const &file : scan.pending) {
+                auto folded = foldCase(file);
+                if (includeCache.count(folded) == 0 && queued.insert(std::move(folded)).second) {
+                    paths.emplace_back(file);
+                }
+            }
+        }
+
+        auto contents = prefetchFiles(paths, readFile, threadCount);
+        std::vector<std::vector<std::string>> includes(paths.size());
+        parallelFor(paths.size(), threadCount, [&](std::size_t idx) {
+            if (std::get<0>(contents[idx])) {
+                extractIncludes(std::get<1>(contents[idx]), includes[idx]);
+            }
+            std::string().swap(std::get<1>(contents[idx]));
+        });
+        for (std::size_t idx = 0; idx < paths.size(); ++idx) {
+            includeCache.try_emplace(foldCase(paths[idx]), std::move(includes[idx]));
+        }
+
+        parallelFor(scans.size(), threadCount,
+                    [&](std::size_t idx) { resolveTarget(scans[idx], index, includeCache); });
+    }
+
+    std::size_t added = 0;
+    for (std::size_t i = 0; i < data.targets.size(); ++i) {
+        auto &target = data.targets[i];
+        auto const &scan = scans[i];
+        if (scan.includeDirs.size() == scan.existingCount) {
+            continue;
+        }
+
+        std::string message;
+        for (auto idx = scan.existingCount; idx < scan.includeDirs.size(); ++idx) {
+            auto relative = std::filesystem::path(scan.includeDirs[idx])
+                                .lexically_relative(scan.directory)
+                                .generic_string();
+            if (relative.empty()) {
+                relative = scan.includeDirs[idx];
+            }
+            for (auto &[name, config] : target.configs) {
+                config.edit().includeDirs.emplace_back(relative);
+            }
+            message += message.empty() ? "" : ", ";
+            message += relative;
+            ++added;
+        }
+        data.diagnostics.emplace_back("Warning: Inferred include directories for " +
+                                      target.name + " - " + message);
+    }
+
+    if (added != 0) {
+        shareIdenticalConfigs(data);
+    }
+    return added;
+}
+
+std::size_t inferPrecompiledHeaders(ProjectData &data, bool apply, unsigned threadCount) {
+    if (data.targets.empty()) {
+        return 0;
+    }
+
+    std::vector<TargetScan> scans(data.targets.size());
+    DirectoryIndex index;
+    prepareScans(data, scans, index);
+
+    // The sources of each target's main language, for those without a
+    // precompiled header of their own.
+    std::vector<std::vector<std::size_t>> targetSources(data.targets.size());
+    std::vector<std::string> paths;
+    std::unordered_map<std::string, std::size_t> pathIndices;
+    for (std::size_t i = 0; i < data.targets.size(); ++i) {
+        auto const &target = data.targets[i];
+        if (std::any_of(target.configs.begin(), target.configs.end(), [](auto const &config) {
+                return !config.second->precompiledHeader.empty();
+            })) {
+            continue;
+        }
+
+        std::vector<std::string> cSources;
+        std::vector<std::string> cxxSources;
+        for (auto const &[name, filter] : target.filters) {
+            for (auto const &file : filter.files) {
+                auto const lastDot = file.find_last_of('.');
+                if (isAbsolutePath(file) || lastDot == std::string::npos) {
+                    continue;
+                }
+                auto const ext = foldCase(file.substr(lastDot + 1));
+                auto const *found = index.find(normalPath(scans[i].directory + '/' + file));
+                if (found == nullptr) {
+                    continue;
+                }
+                if (ext == "c") {
+                    cSources.emplace_back(*found);
+                } else if (ext == "cpp" || ext == "cxx" || ext == "cc" || ext == "c++") {
+                    cxxSources.emplace_back(*found);
+                }
+            }
+        }
+
+        auto &sources = cxxSources.empty() ? cSources : cxxSources;
+        if (sources.size() < 2) {
+            continue;
+        }
+        for (auto const &source : sources) {
+            auto [it, inserted] = pathIndices.try_emplace(foldCase(source), paths.size());
+            if (inserted) {
+                paths.emplace_back(source);
+            }
+            targetSources[i].emplace_back(it->second);
+        }
+    }
+
+    auto contents = prefetchFiles(paths, readFile, threadCount);
+    std::vector<std::vector<std::string>> quoted(paths.size());
+    std::vector<std::vector<std::string>> angled(paths.size());
+    parallelFor(paths.size(), threadCount, [&](std::size_t idx) {
+        if (std::get<0>(contents[idx])) {
+            extractIncludes(std::get<1>(contents[idx]), quoted[idx], &angled[idx]);
+        }
+        std::string().swap(std::get<1>(contents[idx]));
+    });
+
+    struct Candidate {
+        /// As given to target_precompile_headers
+        std::string header;
+        bool system{false};
+        std::size_t fanIn{0};
+        std::size_t bytes{0};
+    };
+    std::vector<std::vector<Candidate>> results(data.targets.size());
+    std::vector<double> savings(data.targets.size(), 0.0);
+
+    parallelFor(data.targets.size(), threadCount, [&](std::size_t i) {
+        auto const &scan = scans[i];
+        auto const &sources = targetSources[i];
+
+        std::unordered_map<std::string, Candidate> headers;
+        for (auto source : sources) {
+            std::unordered_set<std::string> counted;
+            auto count = [&](std::string key, Candidate candidate) {
+                if (!counted.insert(key).second) {
+                    return;
+                }
+                auto [it, inserted] = headers.try_emplace(std::move(key), std::move(candidate));
+                ++it->second.fanIn;
+            };
+            auto countFound = [&](std::string const &path) {
+                // Headers of the target itself are left out.
+                if (path.compare(0, scan.directory.size() + 1, scan.directory + '/') == 0) {
+                    return;
+                }
+                std::error_code error;
+                Candidate candidate;
+                candidate.header = std::filesystem::path(path)
+                                       .lexically_relative(scan.directory)
+                                       .generic_string();
+                candidate.bytes = std::filesystem::file_size(path, error);
+                count(foldCase(path), std::move(candidate));
+            };
+            auto find = [&](std::string const &include) -> std::string const * {
+                for (auto const &includeDir : scan.includeDirs) {
+                    if (auto const *found = index.find(normalPath(includeDir + '/' + include))) {
+                        return found;
+                    }
+                }
+                return nullptr;
+            };
+
+            auto const sourceDir = paths[source].substr(0, paths[source].find_last_of('/'));
+            for (auto const &include : quoted[source]) {
+                auto const *found = index.find(normalPath(sourceDir + '/' + include));
+                if (found == nullptr) {
+                    found = find(include);
+                }
+                if (found != nullptr) {
+                    countFound(*found);
+                }
+            }
+            for (auto const &include : angled[source]) {
+                if (auto const *found = find(include)) {
+                    countFound(*found);
+                } else {
+                    count('<' + foldCase(include) + '>',
+                          Candidate{'<' + include + '>', true, 0, cSystemHeaderBytes});
+                }
+            }
+        }
+
+        auto &candidates = results[i];
+        for (auto &[key, candidate] : headers) {
+            if (candidate.fanIn >= 2 && candidate.fanIn * 2 >= sources.size()) {
+                candidates.emplace_back(std::move(candidate));
+            }
+        }
+        std::sort(candidates.begin(), candidates.end(), [](auto const &lhs, auto const &rhs) {
+            return std::make_tuple(!lhs.system, rhs.fanIn, std::cref(lhs.header)) <
+                   std::make_tuple(!rhs.system, lhs.fanIn, std::cref(rhs.header));
+        });
+        if (candidates.size() > cMaxPrecompiledHeaders) {
+            candidates.resize(cMaxPrecompiledHeaders);
+        }
+
+        // Every source but the one building the precompiled header no longer
+        // parses it.
+        for (auto const &candidate : candidates) {
+            savings[i] += static_cast<double>(candidate.fanIn - 1) *
+                          static_cast<double>(candidate.bytes) / cHeaderBytesPerSecond;
+        }
+    });
+
+    std::size_t suggested = 0;
+    for (std::size_t i = 0; i < data.targets.size(); ++i) {
+        if (results[i].empty()) {
+            continue;
+        }
+        ++suggested;
+
+        auto &target = data.targets[i];
+        std::string message;
+        appendf(message,
+                "Warning: Precompiled header candidates for %s, saving an estimated %.1fs - ",
+                target.name.data(), savings[i]);
+        for (std::size_t idx = 0; idx < results[i].size(); ++idx) {
+            appendf(message, "%s%s (%zu of %zu sources)", (idx == 0) ? "" : ", ",
+                    results[i][idx].header.data(), results[i][idx].fanIn,
+                    targetSources[i].size());
+        }
+        data.diagnostics.emplace_back(std::move(message));
+
+        if (apply) {
+            target.precompileHeaders.clear();
+            for (auto &candidate : results[i]) {
+                target.precompileHeaders.emplace_back(std::move(candidate.header));
+            }
+        }
+    }
+
+    return suggested;
+}
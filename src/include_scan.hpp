@@ -0,0 +1,93 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2018 George Cave <gcave@stablecoder.ca>
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ */
+
+#ifndef INCLUDE_SCAN_HPP
+#define INCLUDE_SCAN_HPP
+
+// cmkizer
+#include "type_defs.hpp"
+
+// C++
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/// The size a system header, with everything it includes, is estimated at.
+constexpr std::size_t cSystemHeaderBytes = 512 * 1024;
+/// The most headers suggested for a single target.
+constexpr std::size_t cMaxPrecompiledHeaders = 8;
+
+/// Extracts the '#include' paths of a source file, without preprocessing it.
+/// Directives are found by searching for '#' with memchr, and must start their
+/// line.
+/// \param text The contents of the source file.
+/// \param includes Receives each quoted path, with forward slashes.
+/// \param pAngled If given, receives each angle-bracketed path.
+void extractIncludes(std::string_view text,
+                     std::vector<std::string> &includes,
+                     std::vector<std::string> *pAngled = nullptr);
+
+/// Infers the include directories that targets are missing, as older project
+/// files often carry none.
+///
+/// Every file of each target's filter groups, and any header found through
+/// them, is scanned in parallel for quoted includes. Those that resolve
+/// neither relative to the including file nor through the target's existing
+/// include directories are looked up, case-insensitively, in an index of the
+/// files beneath the project's directory. The fewest directories resolving
+/// them all are then added to each configuration of the target, preferring
+/// those closest to the target.
+///
+/// A warning is added to the project's diagnostics for each target given
+/// directories.
+/// \param data The project to process, after preprocessing.
+/// \param threadCount The number of threads to use, 0 for the hardware concurrency.
+/// \return The number of include directories added, over all targets.
+std::size_t inferIncludeDirs(ProjectData &data, unsigned threadCount = 0);
+
+/// Suggests precompiled headers for targets that have none, from how often
+/// their sources include each header.
+///
+/// Only the sources of the target's main language are scanned, C++ if it has
+/// any. A header is a candidate when at least half the sources, and at least
+/// two, include it directly. Headers within the target's own directory change
+/// too often to precompile, so only system headers (angle-bracketed, and not
+/// found in the project) and third-party headers (found outside the target's
+/// directory) are considered, system ones first, then by how many sources
+/// include them.
+///
+/// The saving is estimated from each header's fan-in and size, a system
+/// header is counted as cSystemHeaderBytes as its real size is unknown.
+/// A warning listing the candidates and saving is added to the project's
+/// diagnostics for each target with candidates.
+/// \param data The project to process, after preprocessing.
+/// \param apply If true, the candidates are also set as the targets'
+/// precompileHeaders.
+/// \param threadCount The number of threads to use, 0 for the hardware concurrency.
+/// \return The number of targets with candidates.
+std::size_t inferPrecompiledHeaders(ProjectData &data, bool apply, unsigned threadCount = 0);
+
+#endif // INCLUDE_SCAN_HPP
@@ -0,0 +1,296 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2018 George Cave <gcave@stablecoder.ca>
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ */
+
+#include "json.hpp"
+
+// cmkizer
+#include "generators.hpp"
+
+// C++
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+
+void JsonWriter::separate() {
+    if (afterKey || separated) {
+        afterKey = false;
+        separated = false;
+        return;
+    }
+    if (!hasValue.empty()) {
+        if (hasValue.back()) {
+            fputc(',', pOut);
+        }
+        hasValue.back() = true;
+    }
+}
+
+void JsonWriter::writeEscaped(std::string_view str) {
+    fputc('"', pOut);
+    for (char ch : str) {
+        switch (ch) {
+        case '"':
+            fputs("\\\"", pOut);
+            break;
+        case '\\':
+            fputs("\\\\", pOut);
+            break;
+        case '\n':
+            fputs("\\n", pOut);
+            break;
+        case '\r':
+            fputs("\\r", pOut);
+            break;
+        case '\t':
+            fputs("\\t", pOut);
+            break;
+        default:
+            if (static_cast<unsigned char>(ch) < 0x20) {
+                fprintf(pOut, "\\u%04x", static_cast<unsigned>(ch));
+            } else {
+                fputc(ch, pOut);
+            }
+        }
+    }
+    fputc('"', pOut);
+}
+
+void JsonWriter::beginObject() {
+    separate();
+    fputc('{', pOut);
+    hasValue.push_back(false);
+}
+
+void JsonWriter::endObject() {
+    fputc('}', pOut);
+    hasValue.pop_back();
+}
+
+void JsonWriter::beginArray() {
+    separate();
+    fputc('[', pOut);
+    hasValue.push_back(false);
+}
+
+void JsonWriter::endArray() {
+    fputc(']', pOut);
+    hasValue.pop_back();
+}
+
+void JsonWriter::key(std::string_view name) {
+    separate();
+    writeEscaped(name);
+    fputc(':', pOut);
+    afterKey = true;
+}
+
+void JsonWriter::string(std::string_view str) {
+    separate();
+    writeEscaped(str);
+}
+
+void JsonWriter::boolean(bool value) {
+    separate();
+    fputs(value ? "true" : "false", pOut);
+}
+
+void JsonWriter::number(long long value) {
+    separate();
+    fprintf(pOut, "%lld", value);
+}
+
+void JsonWriter::strings(std::vector<std::string> const &list) {
+    beginArray();
+    for (auto const &str : list) {
+        string(str);
+    }
+    endArray();
+}
+
+void JsonWriter::lineBreak() {
+    separate();
+    fputc('\n', pOut);
+    separated = true;
+}
+
+void writeTargetJson(FILE *pOut, TargetData const &target) {
+    JsonWriter json(pOut);
+
+    json.beginObject();
+    json.key("name");
+    json.string(target.name);
+    json.key("displayName");
+    json.string(target.displayName);
+    json.key("fullPath");
+    json.string(target.fullPath);
+    json.key("relativePath");
+    json.string(target.relativePath);
+    json.key("isLibrary");
+    json.boolean(target.isLibrary);
+    json.key("isObjectLibrary");
+    json.boolean(target.isObjectLibrary);
+    json.key("positionIndependent");
+    json.boolean(target.positionIndependent);
+
+    json.key("languages");
+    json.beginObject();
+    json.key("c");
+    json.boolean(target.enableC);
+    json.key("cxx");
+    json.boolean(target.enableCXX);
+    json.key("fortran");
+    json.boolean(target.enableFortran);
+    json.endObject();
+
+    json.key("useMFC");
+    json.number(target.useMFC);
+    json.key("useQt");
+    json.boolean(target.useQt);
+    json.key("dependencies");
+    json.strings(target.dependencies);
+    json.key("files");
+    json.strings(target.allFiles.paths());
+
+    json.key("filters");
+    json.beginObject();
+    for (auto const &[name, filter] : target.filters) {
+        json.key(name);
+        json.beginObject();
+        json.key("files");
+        json.strings(filter.files.paths());
+        json.key("sources");
+        json.boolean(filter.sources);
+        json.key("objects");
+        json.boolean(filter.objects);
+        json.endObject();
+    }
+    json.endObject();
+
+    json.key("configs");
+    json.beginObject();
+    for (auto const &[name, sharedConfig] : target.configs) {
+        auto const &config = *sharedConfig;
+        json.key(name);
+        json.beginObject();
+        json.key("definitions");
+        json.strings(config.definitions);
+        json.key("includeDirs");
+        json.strings(config.includeDirs);
+        json.key("linkLibraries");
+        json.strings(config.linkLibraries);
+        json.key("linkDirs");
+        json.strings(config.linkDirs);
+        json.key("precompiledHeader");
+        json.string(config.precompiledHeader);
+        json.key("optimization");
+        json.string(config.optimization);
+        json.key("enhancedInstructionSet");
+        json.string(config.enhancedInstructionSet);
+        json.key("multiProcessorCompilation");
+        json.boolean(config.multiProcessorCompilation);
+        json.key("wholeProgramOptimization");
+        json.boolean(config.wholeProgramOptimization);
+        json.key("intrinsicFunctions");
+        json.boolean(config.intrinsicFunctions);
+        json.key("functionLevelLinking");
+        json.boolean(config.functionLevelLinking);
+        json.endObject();
+    }
+    json.endObject();
+
+    json.endObject();
+    fputc('\n', pOut);
+}
+
+bool writeCompileCommands(JsonWriter &json, TargetData const &target, std::string_view configName) {
+    auto const selected = selectConfig(target, configName);
+    if (selected == target.configs.end()) {
+        return false;
+    }
+    auto const &config = *selected->second;
+
+    // The files, includes and macros are all relative to the target file.
+    std::error_code error;
+    auto directory = std::filesystem::absolute(
+        std::filesystem::path(target.fullPath).parent_path(), error);
+    std::string const directoryString = directory.lexically_normal().generic_string();
+
+    std::vector<std::string> arguments;
+    arguments.emplace_back();
+    for (auto const &definition : config.definitions) {
+        arguments.emplace_back("-D" + definition);
+    }
+    for (auto const &includeDir : config.includeDirs) {
+        arguments.emplace_back("-I" + includeDir);
+    }
+    for (auto &option : performanceOptions(config, false)) {
+        arguments.emplace_back(std::move(option));
+    }
+    arguments.emplace_back("-c");
+    auto const commonCount = arguments.size();
+
+    for (auto const &[name, filter] : target.filters) {
+        for (auto const &file : filter.files) {
+            auto const lastDot = file.find_last_of('.');
+            if (lastDot == std::string::npos) {
+                continue;
+            }
+            std::string ext = file.substr(lastDot + 1);
+            std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+
+            // A .cxx file only enables C when parsed, so C++ sources count
+            // with either.
+            char const *compiler = nullptr;
+            if (ext == "c" && target.enableC) {
+                compiler = "cc";
+            } else if ((ext == "cpp" || ext == "cxx" || ext == "cc" || ext == "c++") &&
+                       (target.enableCXX || target.enableC)) {
+                compiler = "c++";
+            } else if ((ext == "f" || ext == "for" || ext == "f77" || ext == "f90") &&
+                       target.enableFortran) {
+                compiler = "gfortran";
+            }
+            if (compiler == nullptr) {
+                continue;
+            }
+
+            arguments[0] = compiler;
+            arguments.resize(commonCount);
+            arguments.emplace_back(file);
+
+            json.lineBreak();
+            json.beginObject();
+            json.key("directory");
+            json.string(directoryString);
+            json.key("file");
+            json.string(file);
+            json.key("arguments");
+            json.strings(arguments);
+            json.endObject();
+        }
+    }
+
+    return true;
+}
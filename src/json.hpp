@@ -0,0 +1,89 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2018 George Cave <gcave@stablecoder.ca>
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ */
+
+#ifndef JSON_HPP
+#define JSON_HPP
+
+// cmkizer
+#include "type_defs.hpp"
+
+// C++
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/// A minimal streaming JSON writer, values are written out as they are given
+/// rather than being built up into a document first.
+class JsonWriter {
+  public:
+    explicit JsonWriter(FILE *pOut) : pOut(pOut) {}
+
+    void beginObject();
+    void endObject();
+    void beginArray();
+    void endArray();
+
+    /// Writes the key of the next value within an object.
+    void key(std::string_view name);
+
+    void string(std::string_view str);
+    void boolean(bool value);
+    void number(long long value);
+    /// Writes an array of strings.
+    void strings(std::vector<std::string> const &list);
+
+    /// Starts a new line for the next value, after any separator it needs.
+    void lineBreak();
+
+  private:
+    void separate();
+    void writeEscaped(std::string_view str);
+
+    FILE *pOut;
+    /// For each open object/array, whether anything has been written to it yet
+    std::vector<bool> hasValue;
+    /// Set when a key has been written and its value is pending
+    bool afterKey{false};
+    /// Set when the separator for the next value has already been written
+    bool separated{false};
+};
+
+/// Writes a target as a single-line JSON object followed by a newline, as an
+/// NDJSON record.
+/// \param pOut The file to write to.
+/// \param target The target to write.
+void writeTargetJson(FILE *pOut, TargetData const &target);
+
+/// Writes a compilation database entry for each source of a target, as
+/// objects within an array the writer has open. The compiler is picked by each
+/// file's extension, among the languages the target enables.
+/// \param json The writer, with the database's array open.
+/// \param target The preprocessed target.
+/// \param configName The configuration to use, see selectConfig.
+/// \return False if the target has no such configuration, and nothing was written.
+bool writeCompileCommands(JsonWriter &json, TargetData const &target, std::string_view configName);
+
+#endif // JSON_HPP
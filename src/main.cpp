@@ -23,15 +23,27 @@
  *
  */
 
-#include "file_parser.hpp"
-#include "generators.hpp"
+#include "cmkizer.hpp"
+#include "json.hpp"
+#include "snapshot.hpp"
+#include "tar.hpp"
 #include "util.hpp"
 
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
 #include <string>
 #include <string_view>
+#include <vector>
 
 void printVersion() { printf("cmkizer 18.11\n"); }
 
+void printDiagnostics(std::vector<std::string> const &diagnostics) {
+    for (auto const &message : diagnostics) {
+        printf("%s\n", message.data());
+    }
+}
+
 void printHelp() {
     printVersion();
     printf("\nUsage:\n"
@@ -45,6 +57,65 @@ void printHelp() {
            "'3.13')\n"
            "  -i <str>    changes the include path for installing "
            "headers(default 'include/')\n"
+           "  --target <name>      converts only the named target and its "
+           "dependencies,\n"
+           "                       may be given more than once\n"
+           "  --infer-includes     adds the include directories needed by "
+           "sources'\n"
+           "                       quoted includes that don't resolve otherwise\n"
+           "  --suggest-pch        reports the headers most often included by "
+           "targets\n"
+           "                       without a precompiled header, and the time "
+           "saved\n"
+           "  --emit-pch           as above, and precompiles them\n"
+           "  --share-sources      compiles sources listed by several targets "
+           "with the\n"
+           "                       same settings once, as an OBJECT library\n"
+           "  --unity-build        compiles each target's sources in unity "
+           "groups of\n"
+           "                       about equal size, apart when their "
+           "internal names clash\n"
+           "  --verify-sources     reports listed source files that do not "
+           "exist\n"
+           "  --drop-missing-sources  as above, and leaves them out of the "
+           "output\n"
+           "  --dump-model <file>  writes the preprocessed model to a binary "
+           "snapshot\n"
+           "                       instead of generating CMake\n"
+           "  --load-model <file>  generates CMake from a model snapshot instead "
+           "of\n"
+           "                       parsing a solution\n"
+           "  --stdin-name <file>  reads the input from stdin, using the given "
+           "path for\n"
+           "                       its type and to locate referenced projects\n"
+           "  --from-tar <file>    reads the input from within a tar archive, "
+           "converting\n"
+           "                       every solution in it if no input is given\n"
+           "  --output-dir <dir>   writes the generated files under the given "
+           "directory\n"
+           "  --scan <dir>         converts every solution beneath the "
+           "directory, and\n"
+           "                       every project not referenced by one\n"
+           "  --backend=<name>     generates 'cmake' files(default), or a "
+           "'ninja' build\n"
+           "                       file that builds without CMake\n"
+           "  --config <name>      the configuration built by the ninja "
+           "backend(default\n"
+           "                       each target's first)\n"
+           "  --stream             writes each target's files as soon as it and "
+           "its\n"
+           "                       dependencies are parsed, without hoisting "
+           "common\n"
+           "                       settings\n"
+           "  --compile-commands <config>  writes a compile_commands.json "
+           "beside the\n"
+           "                       input(or in the output directory) for the "
+           "given\n"
+           "                       configuration, instead of generating CMake\n"
+           "  --emit-json <file>   writes each target as a line of JSON as soon "
+           "as it\n"
+           "                       is parsed, instead of generating CMake('-' "
+           "for stdout)\n"
            "  --version   print version number\n"
            "  --help      show this help\n\n");
 }
@@ -56,11 +127,26 @@ int main(int argc, char **argv) {
     }
 
     GlobalSettings globalSettings;
+    std::string dumpModelPath;
+    std::string loadModelPath;
+    std::string jsonPath;
+    std::string compileCommandsConfig;
+    std::string stdinName;
+    std::string tarPath;
+    std::string scanDir;
+    std::string outputDir;
+    // The file being operated upon, if one was given.
+    std::string inputPath;
+    bool stream = false;
 
     // Process the command line arguments, if any.
     for (int idx = 1; idx < argc; ++idx) {
         std::string_view arg = argv[idx];
 
+        if (arg.empty() || arg[0] != '-') {
+            inputPath = arg;
+            continue;
+        }
         if (arg == "--help") {
             printHelp();
             return 0;
@@ -69,14 +155,14 @@ int main(int argc, char **argv) {
             printVersion();
             return 0;
         }
-        if (arg == "-qt" && idx < argc) {
-            globalSettings.qtVersion = std::stoi(argv[idx + 1]);
+        if (arg == "-qt" && idx + 1 < argc) {
+            globalSettings.qtVersion = std::stoi(argv[++idx]);
         }
-        if (arg == "-v" && idx < argc) {
-            globalSettings.cmakeVersion = argv[idx + 1];
+        if (arg == "-v" && idx + 1 < argc) {
+            globalSettings.cmakeVersion = argv[++idx];
         }
-        if (arg == "-i" && idx < argc) {
-            globalSettings.includePath = argv[idx + 1];
+        if (arg == "-i" && idx + 1 < argc) {
+            globalSettings.includePath = argv[++idx];
         }
         if (arg == "-p") {
             globalSettings.cpackType = 1;
@@ -84,25 +170,341 @@ int main(int argc, char **argv) {
         if (arg == "-d") {
             globalSettings.cpackType = 2;
         }
+        if (arg == "--dump-model" && idx + 1 < argc) {
+            dumpModelPath = argv[++idx];
+        }
+        if (arg == "--load-model" && idx + 1 < argc) {
+            loadModelPath = argv[++idx];
+        }
+        if (arg == "--stdin-name" && idx + 1 < argc) {
+            stdinName = argv[++idx];
+        }
+        if (arg == "--from-tar" && idx + 1 < argc) {
+            tarPath = argv[++idx];
+        }
+        if (arg == "--target" && idx + 1 < argc) {
+            globalSettings.selectedTargets.emplace_back(argv[++idx]);
+        }
+        if (arg == "--infer-includes") {
+            globalSettings.inferIncludes = true;
+        }
+        if (arg == "--suggest-pch") {
+            globalSettings.inferPch = std::max(globalSettings.inferPch, 1);
+        }
+        if (arg == "--emit-pch") {
+            globalSettings.inferPch = 2;
+        }
+        if (arg == "--share-sources") {
+            globalSettings.shareSources = true;
+        }
+        if (arg == "--unity-build") {
+            globalSettings.unityBuild = true;
+        }
+        if (arg == "--verify-sources") {
+            globalSettings.verifySources = std::max(globalSettings.verifySources, 1);
+        }
+        if (arg == "--drop-missing-sources") {
+            globalSettings.verifySources = 2;
+        }
+        if (arg == "--scan" && idx + 1 < argc) {
+            scanDir = argv[++idx];
+        }
+        if (arg == "--output-dir" && idx + 1 < argc) {
+            outputDir = argv[++idx];
+        }
+        if (arg.substr(0, 10) == "--backend=") {
+            if (arg.substr(10) == "ninja") {
+                globalSettings.backend = 1;
+            } else if (arg.substr(10) == "cmake") {
+                globalSettings.backend = 0;
+            } else {
+                printf("cmkizer: Unknown backend - %s\n", argv[idx] + 10);
+                return 1;
+            }
+        }
+        if (arg == "--config" && idx + 1 < argc) {
+            globalSettings.buildConfig = argv[++idx];
+        }
+        if (arg == "--stream") {
+            stream = true;
+        }
+        if (arg == "--compile-commands" && idx + 1 < argc) {
+            compileCommandsConfig = argv[++idx];
+        }
+        if (arg == "--emit-json" && idx + 1 < argc) {
+            jsonPath = argv[++idx];
+        }
+    }
+
+    // Only a tar archive, a scan, stdin or a model snapshot can stand in for the input.
+    if (inputPath.empty() && tarPath.empty() && scanDir.empty() && stdinName.empty() &&
+        loadModelPath.empty()) {
+        printf("Error: No input file given\n");
+        return 1;
+    }
+
+    if (!jsonPath.empty()) {
+        FILE *pOut = (jsonPath == "-") ? stdout : fopen(jsonPath.c_str(), "w");
+        if (pOut == nullptr) {
+            printf("cmkizer: Failed to open file to send JSON output to - %s\n",
+                   jsonPath.c_str());
+            return 1;
+        }
+
+        // Targets are written out as they are parsed, rather than collected.
+        auto emitTarget = [&](TargetData &target) {
+            preprocessTarget(target);
+            writeTargetJson(pOut, target);
+            fflush(pOut);
+        };
+
+        auto [projSuccess, projData] =
+            parseProject(inputPath, emitTarget, globalSettings.selectedTargets);
+        if (!projSuccess) {
+            auto [targetSuccess, targetData] = parseTarget(inputPath);
+            if (targetSuccess) {
+                emitTarget(targetData);
+            }
+        }
+
+        if (pOut != stdout) {
+            fclose(pOut);
+        }
+        return 0;
+    }
+
+    if (!compileCommandsConfig.empty()) {
+        std::string outPath = outputDir;
+        if (outPath.empty()) {
+            outPath = std::filesystem::path(inputPath).parent_path().string();
+        }
+        outPath = (std::filesystem::path(outPath) / "compile_commands.json").string();
+
+        FILE *pOut = fopen(outPath.c_str(), "w");
+        if (pOut == nullptr) {
+            printf("cmkizer: Failed to open file to send the compilation database to - %s\n",
+                   outPath.c_str());
+            return 1;
+        }
+
+        // Entries are written out as the targets are parsed, rather than collected,
+        // unless include directories are inferred, which takes every target at once.
+        std::vector<std::string> diagnostics;
+        JsonWriter json(pOut);
+        json.beginArray();
+        auto writeTarget = [&](TargetData const &target) {
+            if (!writeCompileCommands(json, target, compileCommandsConfig)) {
+                diagnostics.emplace_back("Warning: Target has no configuration '" +
+                                         compileCommandsConfig + "', skipping - " + target.name);
+            }
+        };
+        ProjectData collected;
+        auto emitTarget = [&](TargetData &target) {
+            preprocessTarget(target);
+            if (globalSettings.inferIncludes) {
+                collected.targets.emplace_back(std::move(target));
+            } else {
+                writeTarget(target);
+            }
+        };
+
+        bool success = true;
+        auto [projSuccess, projData] =
+            parseProject(inputPath, emitTarget, globalSettings.selectedTargets);
+        if (!projSuccess) {
+            auto [targetSuccess, targetData] = parseTarget(inputPath);
+            if (targetSuccess) {
+                emitTarget(targetData);
+            } else {
+                diagnostics.emplace_back("Error: Could not parse file - " + inputPath);
+                success = false;
+            }
+        }
+        if (!collected.targets.empty()) {
+            collected.path = projData.path;
+            inferIncludeDirs(collected);
+            for (auto const &target : collected.targets) {
+                writeTarget(target);
+            }
+        }
+        fputc('\n', pOut);
+        json.endArray();
+        fputc('\n', pOut);
+        fclose(pOut);
+
+        printDiagnostics(projData.diagnostics);
+        printDiagnostics(collected.diagnostics);
+        printDiagnostics(diagnostics);
+        return success ? 0 : 1;
+    }
+
+    if (!loadModelPath.empty()) {
+        auto [mapSuccess, snapshot] = mapModel(loadModelPath);
+        if (!mapSuccess) {
+            printf("Error: Could not read model snapshot - %s\n", loadModelPath.data());
+            return 1;
+        }
+        auto [loadSuccess, modelData] = loadModel(snapshot, globalSettings);
+        if (!loadSuccess) {
+            printf("Error: Model snapshot is corrupt - %s\n", loadModelPath.data());
+            return 1;
+        }
+
+        GeneratedFiles files;
+        if (globalSettings.backend == 1) {
+            generateNinjaProject(modelData, globalSettings, files, modelData.diagnostics);
+        } else if (modelData.path.empty() && modelData.targets.size() == 1) {
+            // Snapshot of a standalone target.
+            generateCMakeTarget(modelData.targets[0], globalSettings, files);
+        } else {
+            generateCMakeProject(modelData, globalSettings, files);
+        }
+        printDiagnostics(modelData.diagnostics);
+
+        std::vector<std::string> diagnostics;
+        auto const modelDir = std::filesystem::path(
+            modelData.path.empty() && !modelData.targets.empty() ? modelData.targets[0].fullPath
+                                                                 : modelData.path);
+        bool const written =
+            writeGeneratedFiles(files, diagnostics, outputDir, modelDir.parent_path().string());
+        printDiagnostics(diagnostics);
+        return written ? 0 : 1;
     }
 
-    // The last one should be the file we're operating upon, attempt to open it.
-    auto [projSuccess, projData] = parseProject(argv[argc - 1]);
+    if (!dumpModelPath.empty()) {
+        initializeCmkizer();
 
-    if (projSuccess) {
-        projData = projectPreprocessing(projData, globalSettings);
-        generateCMakeProject(projData, globalSettings);
+        ProjectData modelData;
+        auto [projSuccess, projData] =
+            parseProject(inputPath, {}, globalSettings.selectedTargets);
+        if (projSuccess) {
+            modelData = std::move(projData);
+        } else {
+            auto [targetSuccess, targetData] = parseTarget(inputPath);
+            if (!targetSuccess) {
+                printf("Error: Could not parse file - %s\n", inputPath.c_str());
+                return 1;
+            }
+            modelData.targets.emplace_back(std::move(targetData));
+        }
+
+        modelData = prepareProject(std::move(modelData), globalSettings);
+        printDiagnostics(modelData.diagnostics);
+        if (!dumpModel(modelData, globalSettings, dumpModelPath)) {
+            printf("cmkizer: Failed to open file to write the model to - %s\n",
+                   dumpModelPath.data());
+            return 1;
+        }
         return 0;
     }
 
-    auto [targetSuccess, targetData] = parseTarget(argv[argc - 1]);
+    GeneratedFiles files;
+    std::vector<std::string> diagnostics;
+    bool success = false;
+    // Files are placed in the output directory relative to this.
+    std::string baseDir;
 
-    if (targetSuccess) {
-        ProjectData temp;
-        temp.targets.emplace_back(targetData);
-        temp = projectPreprocessing(temp, globalSettings);
-        generateCMakeTarget(temp.targets[0], globalSettings);
+    if (!scanDir.empty()) {
+        // Mirror the scanned tree beneath the output directory.
+        success = convertDirectory(scanDir, globalSettings, files, diagnostics);
+        baseDir = scanDir;
+    } else if (!tarPath.empty()) {
+        // The sources are not within the archive.
+        if (globalSettings.verifySources != 0) {
+            diagnostics.emplace_back(
+                std::string("Warning: Sources can't be verified within a tar archive, ") +
+                (globalSettings.verifySources == 2 ? "--drop-missing-sources"
+                                                   : "--verify-sources") +
+                " is ignored");
+        }
+        if (globalSettings.inferIncludes) {
+            diagnostics.emplace_back("Warning: Include directories can't be inferred within a "
+                                     "tar archive, --infer-includes is ignored");
+        }
+        if (globalSettings.inferPch != 0) {
+            diagnostics.emplace_back(
+                std::string("Warning: Precompiled headers can't be suggested within a tar "
+                            "archive, ") +
+                (globalSettings.inferPch == 2 ? "--emit-pch" : "--suggest-pch") + " is ignored");
+        }
+        if (globalSettings.unityBuild) {
+            diagnostics.emplace_back("Warning: Unity builds can't be grouped within a tar "
+                                     "archive, --unity-build is ignored");
+        }
+        globalSettings.verifySources = 0;
+        globalSettings.inferIncludes = false;
+        globalSettings.inferPch = 0;
+        globalSettings.unityBuild = false;
+
+        auto [tarSuccess, archive] = openTar(tarPath);
+        if (!tarSuccess) {
+            printf("Error: Could not read tar archive - %s\n", tarPath.data());
+            return 1;
+        }
+
+        // Without a separate input, every solution/workspace is converted.
+        std::vector<std::string> inputs;
+        if (inputPath.empty()) {
+            for (auto const &memberPath : archive.memberPaths()) {
+                auto const lastDot = memberPath.find_last_of('.');
+                std::string ext = (lastDot != std::string::npos) ? memberPath.substr(lastDot) : "";
+                std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+                if (ext == ".sln" || ext == ".dsw") {
+                    inputs.emplace_back(memberPath);
+                }
+            }
+        } else {
+            inputs.emplace_back(inputPath);
+        }
+
+        success = true;
+        FileReader readMember = archive.reader();
+        for (auto const &input : inputs) {
+            auto [found, contents] = archive.member(input);
+            if (!found) {
+                diagnostics.emplace_back("Error: Could not find file in archive - " + input);
+                success = false;
+                continue;
+            }
+            // Each solution on its own, so the files they share are compared.
+            GeneratedFiles inputFiles;
+            success = convertProject(input, contents, readMember, globalSettings, inputFiles,
+                                     diagnostics) &&
+                      success;
+            mergeGeneratedFiles(files, inputFiles, input, diagnostics);
+        }
+    } else if (!stdinName.empty()) {
+        std::string contents;
+        char buffer[65536];
+        std::size_t bytesRead;
+        while ((bytesRead = fread(buffer, 1, sizeof(buffer), stdin)) > 0) {
+            contents.append(buffer, bytesRead);
+        }
+        if (stream && globalSettings.backend == 0) {
+            success = streamProject(stdinName, contents, readFile, globalSettings, outputDir,
+                                    diagnostics);
+            printDiagnostics(diagnostics);
+            return success ? 0 : 1;
+        }
+        success =
+            convertProject(stdinName, contents, readFile, globalSettings, files, diagnostics);
+        baseDir = std::filesystem::path(stdinName).parent_path().string();
+    } else if (stream && globalSettings.backend == 0) {
+        auto [found, contents] = readFile(inputPath);
+        if (!found) {
+            printf("Error: Could not read file - %s\n", inputPath.c_str());
+            return 1;
+        }
+        success = streamProject(inputPath, contents, readFile, globalSettings, outputDir,
+                                diagnostics);
+        printDiagnostics(diagnostics);
+        return success ? 0 : 1;
+    } else {
+        success = convertProject(inputPath, globalSettings, files, diagnostics);
+        baseDir = std::filesystem::path(inputPath).parent_path().string();
     }
+    success = writeGeneratedFiles(files, diagnostics, outputDir, baseDir) && success;
+    printDiagnostics(diagnostics);
 
-    return 0;
-}
\ No newline at end of file
+    return success ? 0 : 1;
+}
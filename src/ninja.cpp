@@ -0,0 +1,400 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2018 George Cave <gcave@stablecoder.ca>
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ */
+
+#include "ninja.hpp"
+
+// cmkizer
+#include "generators.hpp"
+#include "graph.hpp"
+#include "util.hpp"
+
+// C++
+#include <algorithm>
+#include <cctype>
+#include <string_view>
+#include <unordered_map>
+
+namespace {
+
+/// Escapes a path for use within a build statement.
+std::string ninjaPath(std::string_view path) {
+    std::string retVal;
+    for (char ch : path) {
+        if (ch == '$' || ch == ' ' || ch == ':') {
+            retVal += '$';
+        }
+        retVal += ch;
+    }
+    return retVal;
+}
+
+/// Quotes a command argument for the shell, then escapes it for use within a
+/// variable.
+std::string ninjaArg(std::string_view arg) {
+    bool const plain = !arg.empty() && std::all_of(arg.begin(), arg.end(), [](unsigned char ch) {
+        return std::isalnum(ch) || std::string_view("_-+=./,@%").find(ch) != std::string::npos;
+    });
+
+    std::string quoted;
+    if (plain) {
+        quoted = arg;
+    } else {
+        quoted = '\'';
+        for (char ch : arg) {
+            if (ch == '\'') {
+                quoted += "'\\''";
+            } else {
+                quoted += ch;
+            }
+        }
+        quoted += '\'';
+    }
+
+    std::string retVal;
+    for (char ch : quoted) {
+        if (ch == '$') {
+            retVal += '$';
+        }
+        retVal += ch;
+    }
+    return retVal;
+}
+
+/// Returns the lower-cased extension of a file, including the dot.
+std::string fileExtension(std::string_view file) {
+    auto const lastDot = file.find_last_of('.');
+    if (lastDot == std::string_view::npos || file.find('/', lastDot) != std::string_view::npos) {
+        return {};
+    }
+    std::string ext(file.substr(lastDot));
+    std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+    return ext;
+}
+
+/// Determines the rule that compiles a file, or nullptr if it is not compiled.
+char const *compileRule(std::string_view file) {
+    auto const ext = fileExtension(file);
+    if (ext == ".c") {
+        return "cc";
+    }
+    if (ext == ".cpp" || ext == ".cxx" || ext == ".cc" || ext == ".c++") {
+        return "cxx";
+    }
+    if (ext == ".f" || ext == ".for" || ext == ".f77" || ext == ".f90" || ext == ".f95") {
+        return "fc";
+    }
+    return nullptr;
+}
+
+/// Turns an entry of a config's link libraries that is not a target into a
+/// linker argument.
+std::string linkArgument(std::string_view directory, std::string const &library) {
+    if (library.compare(0, 2, "-l") == 0 || library.compare(0, 2, "-L") == 0) {
+        return library;
+    }
+    if (library.find('/') != std::string::npos) {
+        return rebasePath(directory, library);
+    }
+    auto const ext = fileExtension(library);
+    if (ext == ".lib" || ext == ".a" || ext == ".so") {
+        return "-l" + library.substr(0, library.size() - ext.size());
+    }
+    return "-l" + library;
+}
+
+/// The output file of a target, relative to the project.
+std::string targetOutput(TargetData const &target) {
+    if (target.isLibrary) {
+        return "$builddir/lib" + ninjaPath(target.name) + ".a";
+    }
+    return "$builddir/" + ninjaPath(target.name);
+}
+
+} // namespace
+
+void generateNinjaProject(ProjectData const &projectData,
+                          GlobalSettings const &globalSettings,
+                          GeneratedFiles &files,
+                          std::vector<std::string> &diagnostics) {
+    std::string outFilePath;
+    auto lastSlash =
+        std::min(projectData.path.find_last_of('/'), projectData.path.find_last_of('\\'));
+    if (lastSlash == std::string::npos) {
+        outFilePath = "./";
+    } else {
+        outFilePath = projectData.path.substr(0, lastSlash + 1);
+    }
+    outFilePath += cNinjaFilename;
+    std::string &out = files[outFilePath];
+    out.clear();
+
+    if (!projectData.name.empty()) {
+        appendf(out, "# %s\n", projectData.name.data());
+    }
+    appendf(out, "ninja_required_version = 1.3\n"
+                 "builddir = build\n\n"
+                 "cc = cc\n"
+                 "cxx = c++\n"
+                 "fc = gfortran\n"
+                 "ar = ar\n\n");
+    for (auto const *rule : {"cc", "cxx", "fc"}) {
+        appendf(out,
+                "rule %s\n"
+                "  command = $%s -MMD -MF $out.d $defines $includes $flags -c $in -o $out\n"
+                "  description = Building %s object $out\n"
+                "  depfile = $out.d\n"
+                "  deps = gcc\n\n",
+                rule, rule, rule);
+    }
+    appendf(out, "rule ar\n"
+                 "  command = rm -f $out && $ar crs $out $in\n"
+                 "  description = Archiving $out\n\n"
+                 "rule link\n"
+                 "  command = $linker $flags -o $out $in $libs\n"
+                 "  description = Linking $out\n");
+
+    // The configuration of each target, skipping those without it.
+    std::unordered_map<std::string, std::size_t> targetIndices;
+    std::vector<std::map<std::string, SharedConfig>::const_iterator> configs;
+    for (std::size_t i = 0; i < projectData.targets.size(); ++i) {
+        auto const &target = projectData.targets[i];
+        targetIndices.try_emplace(target.name, i);
+
+        auto config = selectConfig(target, globalSettings.buildConfig);
+        if (config == target.configs.end()) {
+            diagnostics.emplace_back("Warning: Target has no configuration '" +
+                                     globalSettings.buildConfig + "', skipping - " +
+                                     target.name);
+        }
+        configs.emplace_back(config);
+    }
+    auto hasConfig = [&](std::size_t idx) {
+        return configs[idx] != projectData.targets[idx].configs.end();
+    };
+
+    // Libraries depended upon, directly or not, ordered so each comes before
+    // the libraries it depends upon in turn.
+    auto linkedLibraries = [&](std::size_t root, std::vector<std::size_t> &libraries,
+                               std::vector<std::string> &externals) {
+        std::vector<bool> visited(projectData.targets.size(), false);
+        std::vector<std::size_t> postOrder;
+        auto visit = [&](auto &self, std::size_t idx) -> void {
+            visited[idx] = true;
+            auto const directory = targetDirectory(projectData.targets[idx]);
+            for (auto const &library : configs[idx]->second->linkLibraries) {
+                if (library == projectData.commonTarget) {
+                    continue;
+                }
+                auto it = targetIndices.find(library);
+                if (it != targetIndices.end() && projectData.targets[it->second].isObjectLibrary) {
+                    // Its objects are linked directly.
+                    continue;
+                }
+                if (it == targetIndices.end()) {
+                    auto argument = linkArgument(directory, library);
+                    if (std::find(externals.begin(), externals.end(), argument) ==
+                        externals.end()) {
+                        externals.emplace_back(std::move(argument));
+                    }
+                } else if (!visited[it->second] && hasConfig(it->second) &&
+                           projectData.targets[it->second].isLibrary) {
+                    self(self, it->second);
+                }
+            }
+            postOrder.emplace_back(idx);
+        };
+        visit(visit, root);
+
+        postOrder.pop_back();
+        libraries.assign(postOrder.rbegin(), postOrder.rend());
+    };
+
+    // Targets are written after their dependencies.
+    auto order = std::get<1>(topologicalOrder(projectData.dependencyGraph));
+    if (order.size() != projectData.targets.size()) {
+        // No graph was built, keep the original order.
+        order.resize(projectData.targets.size());
+        for (std::size_t i = 0; i < order.size(); ++i) {
+            order[i] = i;
+        }
+    }
+
+    std::vector<std::string> outputs;
+    // The objects of each OBJECT library, added to the targets linking it.
+    std::vector<std::string> libraryObjects(projectData.targets.size());
+    std::vector<bool> libraryCxx(projectData.targets.size(), false);
+    for (auto idx : order) {
+        if (!hasConfig(idx)) {
+            continue;
+        }
+        auto const &target = projectData.targets[idx];
+        auto const &[configName, sharedConfig] = *configs[idx];
+        auto const &config = *sharedConfig;
+        auto const directory = targetDirectory(target);
+
+        if (target.useQt) {
+            diagnostics.emplace_back("Warning: Qt code generation is not done by the ninja "
+                                     "backend - " +
+                                     target.name);
+        }
+
+        std::string defines;
+        std::string includes;
+        auto addDefine = [&](std::string const &definition) {
+            appendf(defines, " %s", ninjaArg("-D" + definition).data());
+        };
+        auto addInclude = [&](std::string const &includeDir) {
+            appendf(includes, " %s", ninjaArg("-I" + includeDir).data());
+        };
+        for (auto const &definition : config.definitions) {
+            addDefine(definition);
+        }
+        for (auto const &includeDir : config.includeDirs) {
+            addInclude(rebasePath(directory, includeDir));
+        }
+        auto const &linked = config.linkLibraries;
+        if (!projectData.commonTarget.empty() &&
+            std::find(linked.begin(), linked.end(), projectData.commonTarget) != linked.end()) {
+            if (auto common = projectData.commonConfigs.find(configName);
+                common != projectData.commonConfigs.end()) {
+                for (auto const &definition : common->second.definitions) {
+                    addDefine(definition);
+                }
+                for (auto const &includeDir : common->second.includeDirs) {
+                    addInclude(includeDir);
+                }
+            }
+        }
+
+        std::string flags;
+        for (auto const &option : performanceOptions(config, false)) {
+            appendf(flags, " %s", ninjaArg(option).data());
+        }
+        if (config.wholeProgramOptimization) {
+            appendf(flags, " -flto");
+        }
+
+        appendf(out, "\n# %s Target, %s\n", target.name.data(), configName.data());
+
+        std::string objects;
+        bool anyCxx = false;
+        bool anyFortran = false;
+        for (auto const &[filterName, filter] : target.filters) {
+            for (auto const &file : filter.files) {
+                auto const source = rebasePath(directory, file);
+                auto const ext = fileExtension(file);
+                if (ext == ".obj" || ext == ".o") {
+                    appendf(objects, " %s", ninjaPath(source).data());
+                    continue;
+                }
+                auto const *rule = compileRule(file);
+                if (rule == nullptr) {
+                    continue;
+                }
+                anyCxx = anyCxx || std::string_view(rule) == "cxx";
+                anyFortran = anyFortran || std::string_view(rule) == "fc";
+
+                // Objects are kept apart per target, with parent directories
+                // kept within the target's object directory.
+                std::string object = source;
+                for (auto pos = object.find("../"); pos != std::string::npos;
+                     pos = object.find("../", pos)) {
+                    object.replace(pos, 2, "__");
+                }
+                object = "$builddir/" + ninjaPath(target.name) + ".dir/" +
+                         ninjaPath(object.front() == '/' ? object.substr(1) : object) + ".o";
+
+                appendf(out, "build %s: %s %s\n", object.data(), rule, ninjaPath(source).data());
+                appendf(out, "  defines =%s\n  includes =%s\n  flags =%s\n", defines.data(),
+                        includes.data(), flags.data());
+                appendf(objects, " %s", object.data());
+            }
+        }
+
+        if (target.isObjectLibrary) {
+            libraryObjects[idx] = objects;
+            libraryCxx[idx] = anyCxx;
+            appendf(out, "build %s: phony%s\n", ninjaPath(target.name).data(), objects.data());
+            continue;
+        }
+        for (auto const &library : config.linkLibraries) {
+            if (auto it = targetIndices.find(library); it != targetIndices.end()) {
+                objects += libraryObjects[it->second];
+                anyCxx = anyCxx || libraryCxx[it->second];
+            }
+        }
+
+        // Ordered after the targets depended upon that are not linked.
+        std::string orderOnly;
+        if (idx < projectData.dependencyGraph.dependencies.size()) {
+            for (auto dependency : projectData.dependencyGraph.dependencies[idx]) {
+                if (hasConfig(dependency) && !projectData.targets[dependency].isLibrary) {
+                    appendf(orderOnly, " %s", targetOutput(projectData.targets[dependency]).data());
+                }
+            }
+        }
+        if (!orderOnly.empty()) {
+            orderOnly.insert(0, " ||");
+        }
+
+        auto const output = targetOutput(target);
+        outputs.emplace_back(output);
+        if (target.isLibrary) {
+            appendf(out, "build %s: ar%s%s\n", output.data(), objects.data(), orderOnly.data());
+        } else {
+            std::vector<std::size_t> libraries;
+            std::vector<std::string> externals;
+            linkedLibraries(idx, libraries, externals);
+
+            std::string libs;
+            std::string implicitInputs;
+            for (auto library : libraries) {
+                // C++ libraries need the C++ runtime, linked by the C++ driver.
+                anyCxx = anyCxx || projectData.targets[library].enableCXX;
+                auto const libraryOutput = targetOutput(projectData.targets[library]);
+                appendf(libs, " %s", libraryOutput.data());
+                appendf(implicitInputs, " %s", libraryOutput.data());
+            }
+            for (auto const &linkDir : config.linkDirs) {
+                appendf(libs, " %s", ninjaArg("-L" + rebasePath(directory, linkDir)).data());
+            }
+            for (auto const &external : externals) {
+                appendf(libs, " %s", ninjaArg(external).data());
+            }
+
+            appendf(out, "build %s: link%s%s%s%s\n", output.data(), objects.data(),
+                    implicitInputs.empty() ? "" : " |", implicitInputs.data(), orderOnly.data());
+            appendf(out, "  linker = %s\n  flags =%s\n  libs =%s\n",
+                    anyCxx ? "$cxx" : (anyFortran ? "$fc" : "$cc"), flags.data(), libs.data());
+        }
+        appendf(out, "build %s: phony %s\n", ninjaPath(target.name).data(), output.data());
+    }
+
+    appendf(out, "\ndefault");
+    for (auto const &output : outputs) {
+        appendf(out, " %s", output.data());
+    }
+    appendf(out, "\n");
+}
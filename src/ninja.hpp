@@ -0,0 +1,55 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2018 George Cave <gcave@stablecoder.ca>
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ */
+
+#ifndef NINJA_HPP
+#define NINJA_HPP
+
+// cmkizer
+#include "type_defs.hpp"
+
+// C++
+#include <string>
+#include <vector>
+
+/// Generates a build.ninja for a project, beside the project file, that builds
+/// its targets directly with a GCC/Clang style toolchain rather than through
+/// a CMake configure step.
+///
+/// Only the configuration chosen by the global settings is built, each source
+/// of a target's filter groups is compiled with its definitions, include
+/// directories and performance options, and targets are archived as static
+/// libraries or linked as executables. Executables link the libraries they
+/// depend upon, transitively. Build outputs go beneath '$builddir'.
+/// \param projectData The preprocessed project.
+/// \param globalSettings The settings to generate with.
+/// \param files Receives the generated file.
+/// \param diagnostics Receives a warning for each target that cannot be fully
+/// represented.
+void generateNinjaProject(ProjectData const &projectData,
+                          GlobalSettings const &globalSettings,
+                          GeneratedFiles &files,
+                          std::vector<std::string> &diagnostics);
+
+#endif // NINJA_HPP
@@ -0,0 +1,130 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2018 George Cave <gcave@stablecoder.ca>
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ */
+
+#ifndef PARALLEL_HPP
+#define PARALLEL_HPP
+
+// C++
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/// Determines the number of worker threads to use.
+/// \param threadCount The requested count, or 0 to use the hardware concurrency.
+/// \param workCount The number of work items, no more threads than this are used.
+inline unsigned workerCount(unsigned threadCount, std::size_t workCount) noexcept {
+    if (threadCount == 0) {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+    return static_cast<unsigned>(
+        std::min<std::size_t>(threadCount, std::max<std::size_t>(1, workCount)));
+}
+
+/// Calls a function for each index in [0, count) across a number of threads.
+/// Indices are handed out one at a time, so uneven work balances itself.
+/// \param count The number of indices.
+/// \param threadCount The number of threads to use, 0 for the hardware concurrency.
+/// \param func Called with each index, from any of the threads.
+template <typename Func>
+void parallelFor(std::size_t count, unsigned threadCount, Func const &func) {
+    unsigned const workers = workerCount(threadCount, count);
+    if (workers <= 1) {
+        for (std::size_t idx = 0; idx < count; ++idx) {
+            func(idx);
+        }
+        return;
+    }
+
+    std::atomic<std::size_t> next{0};
+    auto worker = [&]() {
+        for (std::size_t idx = next++; idx < count; idx = next++) {
+            func(idx);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(workers - 1);
+    for (unsigned i = 1; i < workers; ++i) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto &thread : threads) {
+        thread.join();
+    }
+}
+
+/// A queue between threads that holds at most a fixed number of items, the
+/// producer waits for room rather than running ahead of the consumer.
+template <typename T>
+class BoundedQueue {
+  public:
+    /// \param capacity The most items held at once, at least one.
+    explicit BoundedQueue(std::size_t capacity) : capacity(std::max<std::size_t>(1, capacity)) {}
+
+    /// Adds an item, waiting while the queue is full.
+    void push(T item) {
+        std::unique_lock<std::mutex> lock(mutex);
+        notFull.wait(lock, [&]() { return items.size() < capacity; });
+        items.emplace_back(std::move(item));
+        notEmpty.notify_one();
+    }
+
+    /// Marks that no more items will be pushed.
+    void close() {
+        std::lock_guard<std::mutex> lock(mutex);
+        closed = true;
+        notEmpty.notify_all();
+    }
+
+    /// Takes the next item, waiting while the queue is empty.
+    /// \param item Receives the item.
+    /// \return False once the queue is closed and empty.
+    bool pop(T &item) {
+        std::unique_lock<std::mutex> lock(mutex);
+        notEmpty.wait(lock, [&]() { return !items.empty() || closed; });
+        if (items.empty()) {
+            return false;
+        }
+        item = std::move(items.front());
+        items.pop_front();
+        notFull.notify_one();
+        return true;
+    }
+
+  private:
+    std::size_t const capacity;
+    std::deque<T> items;
+    bool closed{false};
+    std::mutex mutex;
+    std::condition_variable notFull;
+    std::condition_variable notEmpty;
+};
+
+#endif // PARALLEL_HPP
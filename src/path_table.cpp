@@ -0,0 +1,191 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2018 George Cave <gcave@stablecoder.ca>
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ */
+
+#include "path_table.hpp"
+
+// C++
+#include <algorithm>
+#include <mutex>
+
+namespace {
+
+/// \return The position just after the last separator, 0 if there is none.
+std::size_t leafStart(std::string_view path) {
+    auto const lastSlash = path.find_last_of("/\\");
+    return (lastSlash == std::string_view::npos) ? 0 : lastSlash + 1;
+}
+
+/// \return The index of the highest bit set.
+std::uint32_t highestBit(std::uint32_t value) {
+    std::uint32_t bit = 0;
+    while (value >>= 1) {
+        ++bit;
+    }
+    return bit;
+}
+
+} // namespace
+
+PathTable::PathTable() {
+    blocks[0] = std::make_unique<Directory[]>(std::size_t{1} << cFirstBlockBits);
+    blocks[0][cRoot] = {cRoot, {}};
+    count.store(1, std::memory_order_release);
+}
+
+PathTable::Directory const &PathTable::entry(std::uint32_t id) const noexcept {
+    // Offset so that each block starts at a power of two.
+    auto const position = id + (1u << cFirstBlockBits);
+    auto const bit = highestBit(position);
+    return blocks[bit - cFirstBlockBits][position - (1u << bit)];
+}
+
+std::uint32_t PathTable::find(std::uint32_t parent, std::string_view name) const {
+    auto it = ids.find({parent, name});
+    return (it == ids.end()) ? UINT32_MAX : it->second;
+}
+
+std::uint32_t PathTable::intern(std::string_view directory) {
+    // Each name, up to and including its separator, is looked up within the
+    // directory before it.
+    auto walk = [&](auto &&onMissing) {
+        std::uint32_t id = cRoot;
+        std::size_t start = 0;
+        while (start < directory.size()) {
+            auto const end =
+                std::min(directory.find_first_of("/\\", start), directory.size() - 1) + 1;
+            auto const name = directory.substr(start, end - start);
+            auto next = find(id, name);
+            if (next == UINT32_MAX) {
+                next = onMissing(id, name);
+                if (next == UINT32_MAX) {
+                    return next;
+                }
+            }
+            id = next;
+            start = end;
+        }
+        return id;
+    };
+
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        auto const id = walk([](std::uint32_t, std::string_view) { return UINT32_MAX; });
+        if (id != UINT32_MAX) {
+            return id;
+        }
+    }
+
+    // Anything added by another thread in the meantime is found again.
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    return walk([&](std::uint32_t parent, std::string_view name) {
+        auto const id = count.load(std::memory_order_relaxed);
+        auto const position = id + (1u << cFirstBlockBits);
+        auto const bit = highestBit(position);
+        auto &block = blocks[bit - cFirstBlockBits];
+        if (block == nullptr) {
+            block = std::make_unique<Directory[]>(std::size_t{1} << bit);
+        }
+        auto &added = block[position - (1u << bit)];
+        added = {parent, std::string{name}};
+        ids.emplace(Key{parent, added.name}, id);
+        count.store(id + 1, std::memory_order_release);
+        return id;
+    });
+}
+
+std::string PathTable::path(std::uint32_t id) const {
+    std::string retVal;
+    appendPath(id, retVal);
+    return retVal;
+}
+
+void PathTable::appendPath(std::uint32_t id, std::string &out) const {
+    if (id == cRoot) {
+        return;
+    }
+    auto const &directory = entry(id);
+    appendPath(directory.parent, out);
+    out += directory.name;
+}
+
+bool PathTable::matches(std::uint32_t id, std::string_view directory) const noexcept {
+    for (; id != cRoot; id = entry(id).parent) {
+        auto const &name = entry(id).name;
+        if (directory.size() < name.size() ||
+            directory.substr(directory.size() - name.size()) != name) {
+            return false;
+        }
+        directory.remove_suffix(name.size());
+    }
+    return directory.empty();
+}
+
+PathList::PathList(std::vector<std::string> const &paths, std::shared_ptr<PathTable> table)
+    : pathTable(std::move(table)) {
+    items.reserve(paths.size());
+    for (auto const &path : paths) {
+        emplace_back(path);
+    }
+}
+
+std::string PathList::path(Entry const &entry) const {
+    std::string retVal;
+    pathTable->appendPath(entry.directory, retVal);
+    retVal += entry.leaf;
+    return retVal;
+}
+
+std::uint32_t PathList::internDirectory(std::string_view path, std::size_t start) {
+    if (pathTable == nullptr) {
+        pathTable = std::make_shared<PathTable>();
+    }
+    // Files are mostly listed a directory at a time, which then needs no lock.
+    auto const directory = path.substr(0, start);
+    if (!items.empty() && pathTable->matches(items.back().directory, directory)) {
+        return items.back().directory;
+    }
+    return pathTable->intern(directory);
+}
+
+void PathList::emplace_back(std::string_view path) {
+    auto const start = leafStart(path);
+    auto const directory = internDirectory(path, start);
+    items.push_back({directory, std::string{path.substr(start)}});
+}
+
+void PathList::assign(std::size_t idx, std::string_view path) {
+    auto const start = leafStart(path);
+    auto const directory = internDirectory(path, start);
+    items[idx] = {directory, std::string{path.substr(start)}};
+}
+
+std::vector<std::string> PathList::paths() const {
+    std::vector<std::string> retVal;
+    retVal.reserve(items.size());
+    for (auto const &entry : items) {
+        retVal.emplace_back(path(entry));
+    }
+    return retVal;
+}
@@ -0,0 +1,235 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2018 George Cave <gcave@stablecoder.ca>
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ */
+
+#ifndef PATH_TABLE_HPP
+#define PATH_TABLE_HPP
+
+// C++
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/// The directories of listed files, each stored once, as its parent and its
+/// own name, so a long prefix is only stored by the directory it names. A
+/// table is shared by the lists of a project, so the directories of all its
+/// targets are only stored once.
+///
+/// Directories are never removed or moved, so an id and its path stay valid
+/// for the life of the table, and rebuilding a path takes no lock. Only adding
+/// a directory does, so a table may be filled from several threads.
+class PathTable {
+  public:
+    /// The id of the empty directory, for paths without one.
+    static constexpr std::uint32_t cRoot = 0;
+
+    PathTable();
+    PathTable(PathTable const &) = delete;
+    PathTable &operator=(PathTable const &) = delete;
+
+    /// Finds or adds a directory, and its parents.
+    /// \param directory The directory, ending with its separator, as in 'src/',
+    /// or empty for the root.
+    /// \return The id of the directory.
+    std::uint32_t intern(std::string_view directory);
+
+    /// \return The path of a directory, ending with its separator.
+    std::string path(std::uint32_t id) const;
+
+    /// Appends the path of a directory, ending with its separator.
+    void appendPath(std::uint32_t id, std::string &out) const;
+
+    /// \return True if a directory's path is the one given.
+    bool matches(std::uint32_t id, std::string_view directory) const noexcept;
+
+    /// \return The name of a directory within its parent, with its separator.
+    std::string const &name(std::uint32_t id) const noexcept { return entry(id).name; }
+
+    /// \return The id of the directory a directory is within.
+    std::uint32_t parent(std::uint32_t id) const noexcept { return entry(id).parent; }
+
+    /// \return The number of directories stored.
+    std::size_t size() const noexcept { return count.load(std::memory_order_acquire); }
+
+  private:
+    struct Directory {
+        std::uint32_t parent;
+        std::string name;
+    };
+
+    /// A directory by its parent and its name within it.
+    struct Key {
+        std::uint32_t parent;
+        std::string_view name;
+
+        bool operator==(Key const &other) const noexcept {
+            return parent == other.parent && name == other.name;
+        }
+    };
+    struct KeyHash {
+        std::size_t operator()(Key const &key) const noexcept {
+            auto const hash = std::hash<std::string_view>{}(key.name);
+            return hash ^ (key.parent + 0x9e3779b9 + (hash << 6) + (hash >> 2));
+        }
+    };
+
+    /// Directories are kept in blocks, each twice the size of the one before
+    /// and allocated when first needed, the first holding 1 << cFirstBlockBits.
+    static constexpr std::uint32_t cFirstBlockBits = 4;
+    static constexpr std::size_t cBlockCount = 32 - cFirstBlockBits;
+
+    Directory const &entry(std::uint32_t id) const noexcept;
+
+    /// Finds a directory's name within a parent, with the mutex held.
+    std::uint32_t find(std::uint32_t parent, std::string_view name) const;
+
+    std::array<std::unique_ptr<Directory[]>, cBlockCount> blocks;
+    std::atomic<std::uint32_t> count{0};
+
+    /// Guards the ids, and adding directories
+    mutable std::shared_mutex mutex;
+    std::unordered_map<Key, std::uint32_t, KeyHash> ids;
+};
+
+/// A list of file paths, stored as their directory within a PathTable and
+/// their file name, rather than as full paths that mostly repeat the same
+/// prefixes. Iterating gives the full paths, exactly as they were added.
+///
+/// Copies of a list share its table. A list made without a table gets a table
+/// of its own when a file is first added.
+class PathList {
+  public:
+    /// A listed file.
+    struct Entry {
+        /// The file's directory, within the list's table
+        std::uint32_t directory;
+        /// The remainder of the path, after the last separator
+        std::string leaf;
+    };
+
+    /// Gives the full path of each file, built in a buffer kept by the
+    /// iterator, so a path is only valid until the iterator moves on. Files of
+    /// the same directory reuse its path.
+    class const_iterator {
+      public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = std::string;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = std::string const &;
+
+        const_iterator(PathTable const *pTable, std::vector<Entry>::const_iterator it)
+            : pTable(pTable), it(it) {}
+
+        std::string const &operator*() const {
+            if (it->directory != directory) {
+                directory = it->directory;
+                directoryPath.clear();
+                pTable->appendPath(directory, directoryPath);
+            }
+            path.assign(directoryPath);
+            path += it->leaf;
+            return path;
+        }
+        const_iterator &operator++() {
+            ++it;
+            return *this;
+        }
+        bool operator==(const_iterator const &other) const { return it == other.it; }
+        bool operator!=(const_iterator const &other) const { return it != other.it; }
+
+      private:
+        PathTable const *pTable;
+        std::vector<Entry>::const_iterator it;
+        /// The last directory's path, rebuilt when the directory changes
+        mutable std::uint32_t directory{UINT32_MAX};
+        mutable std::string directoryPath;
+        mutable std::string path;
+    };
+
+    PathList() = default;
+    explicit PathList(std::shared_ptr<PathTable> table) : pathTable(std::move(table)) {}
+    PathList(std::vector<std::string> const &paths, std::shared_ptr<PathTable> table);
+
+    bool empty() const noexcept { return items.empty(); }
+    std::size_t size() const noexcept { return items.size(); }
+    void reserve(std::size_t count) { items.reserve(count); }
+    void clear() noexcept { items.clear(); }
+
+    const_iterator begin() const { return const_iterator(pathTable.get(), items.begin()); }
+    const_iterator end() const { return const_iterator(pathTable.get(), items.end()); }
+
+    /// \return The table holding the directories of the files.
+    std::shared_ptr<PathTable> const &table() const noexcept { return pathTable; }
+
+    /// \return The full path of a file.
+    std::string operator[](std::size_t idx) const { return path(items[idx]); }
+
+    /// \return The full path of one of the list's entries.
+    std::string path(Entry const &entry) const;
+
+    /// Adds a file, splitting it after the last '/' or '\\'.
+    void emplace_back(std::string_view path);
+
+    /// Replaces a file with another path.
+    void assign(std::size_t idx, std::string_view path);
+
+    /// \return The entries, for working on them a directory at a time.
+    std::vector<Entry> const &entries() const noexcept { return items; }
+
+    /// Removes the entries a predicate is true for, keeping the rest in order.
+    template <typename Predicate>
+    void removeIf(Predicate predicate) {
+        auto out = items.begin();
+        for (auto &entry : items) {
+            if (!predicate(static_cast<Entry const &>(entry))) {
+                if (&*out != &entry) {
+                    *out = std::move(entry);
+                }
+                ++out;
+            }
+        }
+        items.erase(out, items.end());
+    }
+
+    /// \return The full paths of every file.
+    std::vector<std::string> paths() const;
+
+  private:
+    /// \return The id of a file's directory, the path up to 'start'.
+    std::uint32_t internDirectory(std::string_view path, std::size_t start);
+
+    std::shared_ptr<PathTable> pathTable;
+    std::vector<Entry> items;
+};
+
+#endif // PATH_TABLE_HPP
@@ -0,0 +1,338 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2018 George Cave <gcave@stablecoder.ca>
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ */
+
+#include "pipeline.hpp"
+
+// cmkizer
+#include "cmkizer.hpp"
+#include "config_pool.hpp"
+#include "file_parser.hpp"
+#include "generators.hpp"
+#include "parallel.hpp"
+#include "unity.hpp"
+#include "verify.hpp"
+
+// C++
+#include <algorithm>
+#include <cctype>
+#include <deque>
+#include <filesystem>
+#include <map>
+#include <set>
+#include <thread>
+#include <unordered_map>
+
+namespace {
+
+std::string toUpper(std::string str) {
+    std::transform(str.begin(), str.end(), str.begin(), ::toupper);
+    return str;
+}
+
+/// Takes the preprocessed targets as they arrive, and emits each one once the
+/// targets it depends upon have been emitted.
+class TargetEmitter {
+  public:
+    TargetEmitter(GlobalSettings const &globalSettings,
+                  std::string_view outputDir,
+                  std::string baseDir)
+        : globalSettings(globalSettings), outputDir(outputDir), baseDir(std::move(baseDir)) {}
+
+    /// Takes a target, emitting it and anything waiting upon it if possible.
+    void arrive(TargetData target) {
+        auto const id = nextId++;
+        auto const key = toUpper(target.displayName);
+        arrivedNames.try_emplace(key, target.name);
+
+        // Each dependency once, as when building the dependency graph.
+        std::vector<std::string> dependencies;
+        for (auto const &dependency : target.dependencies) {
+            auto dependencyKey = toUpper(dependency);
+            if (std::find(dependencies.begin(), dependencies.end(), dependencyKey) ==
+                dependencies.end()) {
+                dependencies.emplace_back(std::move(dependencyKey));
+            }
+        }
+
+        std::size_t remaining = 0;
+        for (auto const &dependency : dependencies) {
+            if (emittedNames.count(dependency) == 0) {
+                blockedBy[dependency].emplace_back(id);
+                ++remaining;
+            }
+        }
+        if (remaining == 0) {
+            emit(std::move(target), std::move(dependencies));
+        } else {
+            waiting.try_emplace(id, Waiting{std::move(target), std::move(dependencies), remaining});
+        }
+    }
+
+    /// Emits every target still waiting, on a cycle or on a dependency that
+    /// never arrived.
+    void finish() {
+        std::string cycle;
+        for (auto &[id, entry] : waiting) {
+            for (auto const &dependency : entry.dependencies) {
+                if (emittedNames.count(dependency) == 0 && arrivedNames.count(dependency) != 0) {
+                    cycle += cycle.empty() ? "" : ", ";
+                    cycle += entry.target.name;
+                    break;
+                }
+            }
+        }
+        if (!cycle.empty()) {
+            diagnostics.emplace_back("Warning: Cyclic dependency between targets - " + cycle);
+        }
+
+        auto stuck = std::move(waiting);
+        for (auto &[id, entry] : stuck) {
+            emit(std::move(entry.target), std::move(entry.dependencies));
+        }
+    }
+
+    /// The contents of the project's own file, following its header.
+    std::string projectOut;
+    std::vector<std::string> diagnostics;
+    bool success{true};
+
+  private:
+    struct Waiting {
+        TargetData target;
+        /// Upper-cased names of the targets depended upon
+        std::vector<std::string> dependencies;
+        std::size_t remaining;
+    };
+
+    /// Emits a target, then any waiting targets that this releases.
+    void emit(TargetData target, std::vector<std::string> dependencies) {
+        std::deque<Waiting> ready;
+        ready.emplace_back(Waiting{std::move(target), std::move(dependencies), 0});
+
+        while (!ready.empty()) {
+            auto entry = std::move(ready.front());
+            ready.pop_front();
+            write(entry);
+
+            auto const key = toUpper(entry.target.displayName);
+            if (!emittedNames.emplace(key).second) {
+                continue;
+            }
+            auto blocked = blockedBy.find(key);
+            if (blocked == blockedBy.end()) {
+                continue;
+            }
+            for (auto id : blocked->second) {
+                auto it = waiting.find(id);
+                if (it != waiting.end() && --it->second.remaining == 0) {
+                    ready.emplace_back(std::move(it->second));
+                    waiting.erase(it);
+                }
+            }
+            blockedBy.erase(blocked);
+        }
+    }
+
+    /// Links a target's dependencies and generates it.
+    void write(Waiting &entry) {
+        // Dependencies are linked by name, whether or not they were emitted yet.
+        for (auto const &dependency : entry.dependencies) {
+            auto it = arrivedNames.find(dependency);
+            if (it == arrivedNames.end()) {
+                continue;
+            }
+            for (auto &[name, config] : entry.target.configs) {
+                config.edit().linkLibraries.emplace_back(it->second);
+            }
+        }
+
+        ungroupListedSources(entry.target);
+        generateCMakeProjectTarget(entry.target, globalSettings, files, projectOut,
+                                   subdirectories);
+        flush();
+    }
+
+    /// Leaves the sources an earlier target of the same directory listed out
+    /// of a target's unity groups. Source properties are per directory, and
+    /// the earlier target's groups were already written.
+    void ungroupListedSources(TargetData &target) {
+        if (!globalSettings.unityBuild) {
+            return;
+        }
+        auto const directory = std::filesystem::path(target.fullPath).parent_path();
+        auto &listed = listedSources[directory.lexically_normal().generic_string()];
+        auto const sourcePath = [&](std::string const &file) {
+            return (directory / file).lexically_normal().generic_string();
+        };
+
+        for (auto &group : target.unityGroups) {
+            group.erase(std::remove_if(group.begin(), group.end(),
+                                       [&](std::string const &file) {
+                                           return listed.count(sourcePath(file)) != 0;
+                                       }),
+                        group.end());
+        }
+        target.unityGroups.erase(
+            std::remove_if(target.unityGroups.begin(), target.unityGroups.end(),
+                           [](std::vector<std::string> const &group) { return group.size() < 2; }),
+            target.unityGroups.end());
+
+        for (auto const &[name, filter] : target.filters) {
+            for (auto const &file : filter.files) {
+                listed.emplace(sourcePath(file));
+            }
+        }
+    }
+
+    /// Writes out whatever was generated since the last flush. A written file
+    /// is kept as a single newline, so a further target sharing its directory
+    /// is still appended as the generator expects.
+    void flush() {
+        for (auto &[path, contents] : files) {
+            bool const written = flushed.count(path) != 0;
+            if (written && contents.size() == 1) {
+                continue;
+            }
+            std::string_view const pending =
+                written ? std::string_view(contents).substr(1) : std::string_view(contents);
+            success =
+                writeGeneratedFile(path, pending, diagnostics, outputDir, baseDir, written) &&
+                success;
+            flushed.emplace(path);
+            contents.assign(1, '\n');
+        }
+    }
+
+    GlobalSettings const &globalSettings;
+    std::string_view outputDir;
+    /// The directory of the converted input
+    std::string baseDir;
+
+    std::size_t nextId{0};
+    /// Name of the first target with each upper-cased display name
+    std::unordered_map<std::string, std::string> arrivedNames;
+    std::set<std::string> emittedNames;
+    /// Waiting targets, by arrival
+    std::map<std::size_t, Waiting> waiting;
+    /// Waiting targets, by the upper-cased names of what they wait on
+    std::unordered_map<std::string, std::vector<std::size_t>> blockedBy;
+
+    GeneratedFiles files;
+    std::set<std::string> flushed;
+    std::set<std::string> subdirectories;
+    /// The sources listed by the written targets, by directory
+    std::unordered_map<std::string, std::set<std::string>> listedSources;
+};
+
+/// Normalizes a single target on its own, as projectPreprocessing would, then
+/// checks its sources and groups them for a unity build, if asked to.
+TargetData prepareTarget(TargetData target,
+                         GlobalSettings const &globalSettings,
+                         std::vector<std::string> &diagnostics) {
+    preprocessTarget(target);
+
+    ProjectData single;
+    single.targets.emplace_back(std::move(target));
+    if (globalSettings.verifySources != 0) {
+        verifySources(single, globalSettings.verifySources == 2, 1);
+    }
+    if (globalSettings.unityBuild) {
+        assignUnityGroups(single, 1);
+    }
+    shareIdenticalConfigs(single);
+    diagnostics.insert(diagnostics.end(), single.diagnostics.begin(), single.diagnostics.end());
+
+    return std::move(single.targets[0]);
+}
+
+} // namespace
+
+bool streamProject(std::string_view path,
+                   std::string_view contents,
+                   FileReader const &readFile,
+                   GlobalSettings const &globalSettings,
+                   std::string_view outputDir,
+                   std::vector<std::string> &diagnostics,
+                   std::size_t queueDepth) {
+    initializeCmkizer();
+    // These need every target at once.
+    if (globalSettings.shareSources) {
+        diagnostics.emplace_back(
+            "Warning: Shared sources can't be found when streaming, --share-sources is ignored");
+    }
+    if (globalSettings.inferIncludes) {
+        diagnostics.emplace_back("Warning: Include directories can't be inferred when "
+                                 "streaming, --infer-includes is ignored");
+    }
+    if (globalSettings.inferPch != 0) {
+        diagnostics.emplace_back(
+            std::string("Warning: Precompiled headers can't be suggested when streaming, ") +
+            (globalSettings.inferPch == 2 ? "--emit-pch" : "--suggest-pch") + " is ignored");
+    }
+
+    std::string const baseDir = std::filesystem::path(path).parent_path().string();
+    TargetEmitter emitter(globalSettings, outputDir, baseDir);
+    BoundedQueue<TargetData> queue(queueDepth);
+
+    std::thread generator([&]() {
+        TargetData target;
+        while (queue.pop(target)) {
+            emitter.arrive(prepareTarget(std::move(target), globalSettings, emitter.diagnostics));
+        }
+        emitter.finish();
+    });
+
+    auto [projSuccess, projData] =
+        parseProject(path, contents, readFile,
+                     [&](TargetData &target) { queue.push(std::move(target)); },
+                     globalSettings.selectedTargets);
+    queue.close();
+    generator.join();
+
+    if (!projSuccess) {
+        auto [targetSuccess, targetData] = parseTarget(path, contents, readFile);
+        if (!targetSuccess) {
+            diagnostics.emplace_back("Error: Could not parse file - " + std::string{path});
+            return false;
+        }
+
+        GeneratedFiles files;
+        generateCMakeTarget(prepareTarget(std::move(targetData), globalSettings, diagnostics),
+                            globalSettings, files);
+        return writeGeneratedFiles(files, diagnostics, outputDir, baseDir);
+    }
+
+    diagnostics.insert(diagnostics.end(), projData.diagnostics.begin(),
+                       projData.diagnostics.end());
+    diagnostics.insert(diagnostics.end(), emitter.diagnostics.begin(), emitter.diagnostics.end());
+
+    // The project's own file, its header followed by what was gathered.
+    GeneratedFiles files;
+    generateCMakeProject(projData, globalSettings, files);
+    for (auto &[filePath, projectOut] : files) {
+        projectOut += emitter.projectOut;
+    }
+    return writeGeneratedFiles(files, diagnostics, outputDir, baseDir) && emitter.success;
+}
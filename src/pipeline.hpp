@@ -0,0 +1,70 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2018 George Cave <gcave@stablecoder.ca>
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ */
+
+#ifndef PIPELINE_HPP
+#define PIPELINE_HPP
+
+// cmkizer
+#include "type_defs.hpp"
+
+// C++
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/// The number of parsed targets that may wait for generation by default.
+constexpr std::size_t cStreamQueueDepth = 16;
+
+/// Converts a solution/workspace as a pipeline, writing the CMake files out as
+/// it goes rather than after the whole model has been built.
+///
+/// Targets are handed from the parser through a bounded queue to a generating
+/// thread, which preprocesses each one and, once every target it depends upon
+/// has been emitted, links the dependencies, writes the target's file and
+/// releases it. Only the targets still waiting for a dependency are held, the
+/// project's own file is written last. Targets waiting on a cycle or on a
+/// dependency that never arrives are emitted at the end.
+///
+/// As the targets are never all held at once, settings common to most targets
+/// are not hoisted into a shared target, as they are by projectPreprocessing.
+/// \param path The path of the solution, workspace or project file.
+/// \param contents The contents of the file.
+/// \param readFile Provides the contents of referenced files.
+/// \param globalSettings The settings to generate with.
+/// \param outputDir If set, the files are written to this directory, at their
+/// paths relative to the input's directory.
+/// \param diagnostics Receives any errors or warnings encountered.
+/// \param queueDepth The number of parsed targets that may wait for generation.
+/// \return True if the file could be parsed and every file was written.
+bool streamProject(std::string_view path,
+                   std::string_view contents,
+                   FileReader const &readFile,
+                   GlobalSettings const &globalSettings,
+                   std::string_view outputDir,
+                   std::vector<std::string> &diagnostics,
+                   std::size_t queueDepth = cStreamQueueDepth);
+
+#endif // PIPELINE_HPP
@@ -0,0 +1,394 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2018 George Cave <gcave@stablecoder.ca>
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ */
+
+#include "prefetch.hpp"
+
+// cmkizer
+#include "parallel.hpp"
+#include "util.hpp"
+
+// C++
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <deque>
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define PREFETCH_IO_URING
+#endif
+#endif
+
+#if defined(PREFETCH_IO_URING)
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+#if defined(PREFETCH_IO_URING)
+
+/// A minimal io_uring, driven directly through the system calls.
+class Ring {
+  public:
+    Ring() = default;
+    Ring(Ring const &) = delete;
+    Ring &operator=(Ring const &) = delete;
+
+    ~Ring() {
+        if (sqes != nullptr) {
+            munmap(sqes, sqesSize);
+        }
+        if (cqRing != nullptr) {
+            munmap(cqRing, cqRingSize);
+        }
+        if (sqRing != nullptr) {
+            munmap(sqRing, sqRingSize);
+        }
+        if (fd != -1) {
+            close(fd);
+        }
+    }
+
+    /// \return True if the ring could be set up, false if io_uring is not
+    /// available.
+    bool init(unsigned entries) {
+        io_uring_params params{};
+        fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+        if (fd < 0) {
+            return false;
+        }
+
+        sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+
+        sqRing = mmap(nullptr, sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd,
+                      IORING_OFF_SQ_RING);
+        cqRing = mmap(nullptr, cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd,
+                      IORING_OFF_CQ_RING);
+        void *sqeMap = mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                            fd, IORING_OFF_SQES);
+        if (sqRing == MAP_FAILED || cqRing == MAP_FAILED || sqeMap == MAP_FAILED) {
+            sqRing = (sqRing == MAP_FAILED) ? nullptr : sqRing;
+            cqRing = (cqRing == MAP_FAILED) ? nullptr : cqRing;
+            sqes = (sqeMap == MAP_FAILED) ? nullptr : static_cast<io_uring_sqe *>(sqeMap);
+            return false;
+        }
+        sqes = static_cast<io_uring_sqe *>(sqeMap);
+
+        auto *sqBase = static_cast<char *>(sqRing);
+        sqHead = reinterpret_cast<unsigned *>(sqBase + params.sq_off.head);
+        sqTail = reinterpret_cast<unsigned *>(sqBase + params.sq_off.tail);
+        sqMask = *reinterpret_cast<unsigned *>(sqBase + params.sq_off.ring_mask);
+        sqArray = reinterpret_cast<unsigned *>(sqBase + params.sq_off.array);
+        sqEntries = params.sq_entries;
+        sqLocalTail = *sqTail;
+
+        auto *cqBase = static_cast<char *>(cqRing);
+        cqHead = reinterpret_cast<unsigned *>(cqBase + params.cq_off.head);
+        cqTail = reinterpret_cast<unsigned *>(cqBase + params.cq_off.tail);
+        cqMask = *reinterpret_cast<unsigned *>(cqBase + params.cq_off.ring_mask);
+        cqes = reinterpret_cast<io_uring_cqe *>(cqBase + params.cq_off.cqes);
+
+        return true;
+    }
+
+    unsigned capacity() const noexcept { return sqEntries; }
+
+    /// \return The next submission entry to fill in, or nullptr if the queue is full.
+    io_uring_sqe *nextSqe() {
+        unsigned const head = __atomic_load_n(sqHead, __ATOMIC_ACQUIRE);
+        if (sqLocalTail - head >= sqEntries) {
+            return nullptr;
+        }
+        unsigned const idx = sqLocalTail & sqMask;
+        sqArray[idx] = idx;
+        ++sqLocalTail;
+        ++unsubmitted;
+
+        return &sqes[idx];
+    }
+
+    /// Submits the queued entries and waits for at least one completion.
+    bool submitAndWait() {
+        __atomic_store_n(sqTail, sqLocalTail, __ATOMIC_RELEASE);
+        long const result = syscall(__NR_io_uring_enter, fd, unsubmitted, 1,
+                                    IORING_ENTER_GETEVENTS, nullptr, 0);
+        if (result < 0 && errno != EINTR) {
+            return false;
+        }
+        if (result > 0) {
+            unsubmitted -= static_cast<unsigned>(result);
+        }
+        return true;
+    }
+
+    bool popCompletion(io_uring_cqe &completion) {
+        unsigned const head = *cqHead;
+        if (head == __atomic_load_n(cqTail, __ATOMIC_ACQUIRE)) {
+            return false;
+        }
+        completion = cqes[head & cqMask];
+        __atomic_store_n(cqHead, head + 1, __ATOMIC_RELEASE);
+        return true;
+    }
+
+  private:
+    int fd{-1};
+    void *sqRing{nullptr};
+    std::size_t sqRingSize{0};
+    void *cqRing{nullptr};
+    std::size_t cqRingSize{0};
+    io_uring_sqe *sqes{nullptr};
+    std::size_t sqesSize{0};
+
+    unsigned *sqHead{nullptr};
+    unsigned *sqTail{nullptr};
+    unsigned sqMask{0};
+    unsigned *sqArray{nullptr};
+    unsigned sqEntries{0};
+    unsigned sqLocalTail{0};
+    unsigned unsubmitted{0};
+
+    unsigned *cqHead{nullptr};
+    unsigned *cqTail{nullptr};
+    unsigned cqMask{0};
+    io_uring_cqe *cqes{nullptr};
+};
+
+/// The progress of a single file through the ring.
+struct RingFile {
+    int fd{-1};
+    std::size_t offset{0};
+    /// Set once the file has been read, or has failed
+    bool done{false};
+    /// Set if the kernel does not support an operation, so the file should be
+    /// read some other way
+    bool unsupported{false};
+};
+
+/// Keeps up to the ring's capacity of operations in flight, one for each file
+/// that 'prepare' fills in an operation for, until all have completed. If
+/// 'complete' returns true, the file is prepared again, such as for the rest
+/// of a short read.
+template <typename Prepare, typename Complete>
+bool runRing(Ring &ring, std::size_t count, Prepare const &prepare, Complete const &complete) {
+    std::deque<std::size_t> ready;
+    for (std::size_t idx = 0; idx < count; ++idx) {
+        ready.emplace_back(idx);
+    }
+    std::size_t inFlight = 0;
+
+    while (true) {
+        while (!ready.empty() && inFlight < ring.capacity()) {
+            io_uring_sqe operation{};
+            if (!prepare(ready.front(), operation)) {
+                ready.pop_front();
+                continue;
+            }
+            io_uring_sqe *sqe = ring.nextSqe();
+            if (sqe == nullptr) {
+                break;
+            }
+            *sqe = operation;
+            sqe->user_data = ready.front();
+            ready.pop_front();
+            ++inFlight;
+        }
+
+        if (inFlight == 0 && ready.empty()) {
+            return true;
+        }
+        if (!ring.submitAndWait()) {
+            return false;
+        }
+
+        io_uring_cqe completion{};
+        while (ring.popCompletion(completion)) {
+            --inFlight;
+            auto const idx = static_cast<std::size_t>(completion.user_data);
+            if (complete(idx, completion.res)) {
+                ready.emplace_front(idx);
+            }
+        }
+    }
+}
+
+/// The number of files held open at a time.
+constexpr std::size_t cRingBatchSize = 256;
+
+/// Reads files through io_uring, marking those it could not handle.
+/// \return False if the ring failed, and should not be used further.
+bool ringReadFiles(Ring &ring,
+                   std::string const *paths,
+                   std::tuple<bool, std::string> *results,
+                   RingFile *files,
+                   std::size_t count) {
+
+    // Open every file.
+    bool ringOk = runRing(
+        ring, count,
+        [&](std::size_t idx, io_uring_sqe &sqe) {
+            sqe.opcode = IORING_OP_OPENAT;
+            sqe.fd = AT_FDCWD;
+            sqe.addr = reinterpret_cast<std::uint64_t>(paths[idx].c_str());
+            sqe.open_flags = O_RDONLY | O_CLOEXEC;
+            return true;
+        },
+        [&](std::size_t idx, int result) {
+            if (result >= 0) {
+                files[idx].fd = result;
+            } else if (result == -EINVAL || result == -EOPNOTSUPP || result == -EMFILE ||
+                       result == -ENFILE) {
+                files[idx].unsupported = true;
+            } else {
+                files[idx].done = true;
+            }
+            return false;
+        });
+
+    // Size the buffers, the attributes are fresh from the open.
+    for (std::size_t idx = 0; idx < count; ++idx) {
+        struct stat fileStat {};
+        if (files[idx].fd != -1 && fstat(files[idx].fd, &fileStat) == 0) {
+            std::get<1>(results[idx]).resize(static_cast<std::size_t>(fileStat.st_size));
+        }
+    }
+
+    // Read every opened file, resubmitting short reads.
+    ringOk = ringOk &&
+             runRing(
+                 ring, count,
+                 [&](std::size_t idx, io_uring_sqe &sqe) {
+                     auto &file = files[idx];
+                     auto &buffer = std::get<1>(results[idx]);
+                     if (file.fd == -1 || file.done) {
+                         return false;
+                     }
+                     if (file.offset == buffer.size()) {
+                         // Empty file
+                         file.done = true;
+                         std::get<0>(results[idx]) = true;
+                         return false;
+                     }
+                     sqe.opcode = IORING_OP_READ;
+                     sqe.fd = file.fd;
+                     sqe.off = file.offset;
+                     sqe.addr = reinterpret_cast<std::uint64_t>(buffer.data() + file.offset);
+                     sqe.len = static_cast<std::uint32_t>(
+                         std::min<std::size_t>(buffer.size() - file.offset, 1u << 30));
+                     return true;
+                 },
+                 [&](std::size_t idx, int result) {
+                     auto &file = files[idx];
+                     auto &buffer = std::get<1>(results[idx]);
+                     if (result == -EINTR || result == -EAGAIN) {
+                         return true;
+                     }
+                     if (result == -EINVAL || result == -EOPNOTSUPP) {
+                         file.unsupported = true;
+                         return false;
+                     }
+                     if (result < 0) {
+                         file.done = true;
+                         buffer.clear();
+                         return false;
+                     }
+                     file.offset += static_cast<std::size_t>(result);
+                     if (result == 0 || file.offset == buffer.size()) {
+                         // Finished, or the file shrank since it was sized.
+                         buffer.resize(file.offset);
+                         file.done = true;
+                         std::get<0>(results[idx]) = true;
+                         return false;
+                     }
+                     return true;
+                 });
+
+    for (std::size_t idx = 0; idx < count; ++idx) {
+        auto &file = files[idx];
+        if (file.fd != -1) {
+            close(file.fd);
+            file.fd = -1;
+        }
+        if (!ringOk && !file.done) {
+            file.unsupported = true;
+        }
+    }
+
+    return ringOk;
+}
+
+#endif
+
+} // namespace
+
+std::vector<std::tuple<bool, std::string>>
+prefetchFiles(std::vector<std::string> const &paths, FileReader const &readFile,
+              unsigned threadCount) {
+    std::vector<std::tuple<bool, std::string>> results(paths.size());
+    std::vector<bool> remaining(paths.size(), true);
+
+#if defined(PREFETCH_IO_URING)
+    using DiskReader = std::tuple<bool, std::string> (*)(std::string const &);
+    auto const *diskReader = readFile.target<DiskReader>();
+    Ring ring;
+    if (diskReader != nullptr && *diskReader == &::readFile && paths.size() > 1 &&
+        ring.init(64)) {
+        std::vector<RingFile> files(paths.size());
+        for (std::size_t start = 0; start < paths.size(); start += cRingBatchSize) {
+            auto const count = std::min(cRingBatchSize, paths.size() - start);
+            bool const ringOk =
+                ringReadFiles(ring, &paths[start], &results[start], &files[start], count);
+            for (std::size_t idx = start; idx < start + count; ++idx) {
+                remaining[idx] = files[idx].unsupported;
+                if (files[idx].unsupported) {
+                    results[idx] = std::make_tuple(false, std::string());
+                }
+            }
+            if (!ringOk) {
+                break;
+            }
+        }
+    }
+#endif
+
+    std::vector<std::size_t> pending;
+    for (std::size_t idx = 0; idx < paths.size(); ++idx) {
+        if (remaining[idx]) {
+            pending.emplace_back(idx);
+        }
+    }
+    parallelFor(pending.size(), threadCount, [&](std::size_t idx) {
+        results[pending[idx]] = readFile(paths[pending[idx]]);
+    });
+
+    return results;
+}
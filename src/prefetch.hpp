@@ -0,0 +1,54 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2018 George Cave <gcave@stablecoder.ca>
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ */
+
+#ifndef PREFETCH_HPP
+#define PREFETCH_HPP
+
+// cmkizer
+#include "type_defs.hpp"
+
+// C++
+#include <string>
+#include <tuple>
+#include <vector>
+
+/// Reads a set of files all at once, rather than one after another, so that
+/// reading many files over a high latency filesystem is limited by bandwidth
+/// rather than round trips.
+///
+/// Files read from disk through 'readFile' (the plain disk reader) are read
+/// through io_uring on Linux where available, with all opens and then all
+/// reads in flight together. Otherwise, or for any other reader, the reader is
+/// called from a pool of threads.
+/// \param paths The files to read.
+/// \param readFile The reader the files would otherwise be read through.
+/// \param threadCount The number of threads to use when falling back to a
+/// thread pool, 0 for the hardware concurrency.
+/// \return For each path, in order, whether it was read and its contents.
+std::vector<std::tuple<bool, std::string>>
+prefetchFiles(std::vector<std::string> const &paths, FileReader const &readFile,
+              unsigned threadCount = 0);
+
+#endif // PREFETCH_HPP
@@ -37,11 +37,60 @@
 #include <cstring>
 #include <fstream>
 
-std::tuple<bool, TargetData> projTargetParse(std::string_view targetPath) {
+/// Parses the build performance related attributes of a compiler tool node.
+/// \param toolNode The VCCLCompilerTool node.
+/// \param config The TargetConfig to fill.
+void parseCompilerPerformance(xmlNode *toolNode, TargetConfig &config) {
+    auto temp = (const char *)xmlGetProp(toolNode, (const xmlChar *)"UsePrecompiledHeader");
+    // '2' is 'use' from VS2005 onwards, '3' for VS2003.
+    if (temp != nullptr && (strcmp(temp, "2") == 0 || strcmp(temp, "3") == 0 ||
+                            strcmp(temp, "pchUseUsingSpecific") == 0)) {
+        temp = (const char *)xmlGetProp(toolNode, (const xmlChar *)"PrecompiledHeaderThrough");
+        config.precompiledHeader = (temp != nullptr) ? temp : "stdafx.h";
+    }
+
+    temp = (const char *)xmlGetProp(toolNode, (const xmlChar *)"AdditionalOptions");
+    if (temp != nullptr) {
+        config.multiProcessorCompilation = strstr(temp, "/MP") != nullptr;
+    }
+    temp = (const char *)xmlGetProp(toolNode, (const xmlChar *)"WholeProgramOptimization");
+    if (temp != nullptr) {
+        config.wholeProgramOptimization = strcmp(temp, "true") == 0;
+    }
+    temp = (const char *)xmlGetProp(toolNode, (const xmlChar *)"Optimization");
+    if (temp != nullptr) {
+        constexpr const char *cLevels[] = {"Disabled", "MinSpace", "MaxSpeed", "Full"};
+        if (temp[0] >= '0' && temp[0] <= '3') {
+            config.optimization = cLevels[temp[0] - '0'];
+        }
+    }
+    temp = (const char *)xmlGetProp(toolNode, (const xmlChar *)"EnableIntrinsicFunctions");
+    if (temp != nullptr) {
+        config.intrinsicFunctions = strcmp(temp, "true") == 0;
+    }
+    temp = (const char *)xmlGetProp(toolNode, (const xmlChar *)"EnableEnhancedInstructionSet");
+    if (temp != nullptr) {
+        if (strcmp(temp, "1") == 0) {
+            config.enhancedInstructionSet = "StreamingSIMDExtensions";
+        } else if (strcmp(temp, "2") == 0) {
+            config.enhancedInstructionSet = "StreamingSIMDExtensions2";
+        }
+    }
+    temp = (const char *)xmlGetProp(toolNode, (const xmlChar *)"EnableFunctionLevelLinking");
+    if (temp != nullptr) {
+        config.functionLevelLinking = strcmp(temp, "true") == 0;
+    }
+}
+
+std::tuple<bool, TargetData> projTargetParse(std::string_view targetPath,
+                                             std::string_view contents,
+                                             std::shared_ptr<PathTable> pathTable) {
     TargetData data;
     data.fullPath = targetPath;
+    data.allFiles = PathList(std::move(pathTable));
 
-    xmlDoc *document = xmlReadFile(targetPath.data(), nullptr, 0);
+    xmlDoc *document =
+        xmlReadMemory(contents.data(), static_cast<int>(contents.size()), nullptr, nullptr, 0);
     if (document == nullptr) {
         return std::make_tuple(false, data);
     }
@@ -92,6 +141,11 @@ std::tuple<bool, TargetData> projTargetParse(std::string_view targetPath) {
                             data.isLibrary = true;
                         }
                     }
+                    temp = (const char *)xmlGetProp(configNode,
+                                                    (const xmlChar *)"WholeProgramOptimization");
+                    if (temp != nullptr) {
+                        config.wholeProgramOptimization = strcmp(temp, "0") != 0;
+                    }
 
                     for (xmlNode *toolNode = configNode->children; toolNode != configNode->last;
                          toolNode = toolNode->next) {
@@ -113,6 +167,7 @@ std::tuple<bool, TargetData> projTargetParse(std::string_view targetPath) {
                                 if (temp != nullptr) {
                                     config.includeDirs = parseItems(temp);
                                 }
+                                parseCompilerPerformance(toolNode, config);
                             } else if (toolName == "VCLinkerTool" || toolName == "VFLinkerTool") {
                                 auto temp = (const char *)xmlGetProp(toolNode,
                                                                      (const xmlChar *)"OutputFile");
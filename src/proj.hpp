@@ -30,13 +30,18 @@
 #include "type_defs.hpp"
 
 // C++
+#include <memory>
 #include <string>
 #include <tuple>
 
 /// Parses a vcproj or vfproj target file.
 /// \param targetPath The path of the file to parse.
+/// \param contents The contents of the file.
+/// \param pathTable Receives the directories of the target's files.
 /// \return A boolean representing the parse success, and the associated parsed
 /// TargetData.
-std::tuple<bool, TargetData> projTargetParse(std::string_view targetPath);
+std::tuple<bool, TargetData> projTargetParse(std::string_view targetPath,
+                                             std::string_view contents,
+                                             std::shared_ptr<PathTable> pathTable);
 
 #endif // PROJ_HPP
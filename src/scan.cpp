@@ -0,0 +1,188 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2018 George Cave <gcave@stablecoder.ca>
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ */
+
+#include "scan.hpp"
+
+// cmkizer
+#include "parallel.hpp"
+
+// C++
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <limits>
+#include <mutex>
+#include <thread>
+
+namespace {
+
+/// The directories waiting to be read by a single thread. The owner works from
+/// the back, thieves take from the front where the larger subtrees tend to be.
+struct DirectoryQueue {
+    std::mutex mutex;
+    std::deque<std::string> directories;
+};
+
+enum class FileKind { Other, Solution, Target };
+
+FileKind classifyFile(std::string const &fileName) {
+    auto const lastDot = fileName.find_last_of('.');
+    if (lastDot == std::string::npos) {
+        return FileKind::Other;
+    }
+    std::string ext = fileName.substr(lastDot);
+    std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+
+    if (ext == ".sln" || ext == ".dsw") {
+        return FileKind::Solution;
+    }
+    if (ext == ".vcxproj" || ext == ".vcproj" || ext == ".vfproj" || ext == ".dsp") {
+        return FileKind::Target;
+    }
+    return FileKind::Other;
+}
+
+bool takeDirectory(DirectoryQueue &queue, bool fromBack, std::string &directory) {
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.directories.empty()) {
+        return false;
+    }
+    if (fromBack) {
+        directory = std::move(queue.directories.back());
+        queue.directories.pop_back();
+    } else {
+        directory = std::move(queue.directories.front());
+        queue.directories.pop_front();
+    }
+    return true;
+}
+
+} // namespace
+
+ScanResult scanDirectory(std::string_view rootDir, unsigned threadCount) {
+    unsigned const workers = workerCount(threadCount, std::numeric_limits<std::size_t>::max());
+    std::vector<DirectoryQueue> queues(workers);
+    std::vector<ScanResult> results(workers);
+
+    // Directories queued or being read, the walk is over once this hits zero.
+    std::atomic<std::size_t> pending{1};
+    // Directories queued but not yet taken, idle workers sleep while this is zero.
+    std::atomic<std::size_t> queued{1};
+    queues[0].directories.emplace_back(rootDir);
+
+    std::mutex idleMutex;
+    std::condition_variable idle;
+    // Taking the lock first means a worker can't miss this between checking and waiting.
+    auto wakeIdle = [&](bool all) {
+        {
+            std::lock_guard<std::mutex> lock(idleMutex);
+        }
+        if (all) {
+            idle.notify_all();
+        } else {
+            idle.notify_one();
+        }
+    };
+
+    auto worker = [&](unsigned self) {
+        ScanResult &result = results[self];
+
+        while (pending.load() != 0) {
+            std::string directory;
+            bool found = takeDirectory(queues[self], true, directory);
+            for (unsigned offset = 1; !found && offset < workers; ++offset) {
+                found = takeDirectory(queues[(self + offset) % workers], false, directory);
+            }
+            if (!found) {
+                std::unique_lock<std::mutex> lock(idleMutex);
+                idle.wait(lock, [&]() { return pending.load() == 0 || queued.load() != 0; });
+                continue;
+            }
+            --queued;
+
+            std::error_code error;
+            for (std::filesystem::directory_iterator it(directory, error), end;
+                 !error && it != end; it.increment(error)) {
+                auto const &entry = *it;
+                std::string fileName = entry.path().filename().string();
+
+                std::error_code typeError;
+                if (entry.is_directory(typeError)) {
+                    if (fileName[0] != '.' && !entry.is_symlink(typeError)) {
+                        ++pending;
+                        ++queued;
+                        {
+                            std::lock_guard<std::mutex> lock(queues[self].mutex);
+                            queues[self].directories.emplace_back(entry.path().generic_string());
+                        }
+                        wakeIdle(false);
+                    }
+                    continue;
+                }
+
+                switch (classifyFile(fileName)) {
+                case FileKind::Solution:
+                    result.solutions.emplace_back(entry.path().generic_string());
+                    break;
+                case FileKind::Target:
+                    result.targets.emplace_back(entry.path().generic_string());
+                    break;
+                case FileKind::Other:
+                    break;
+                }
+            }
+
+            if (--pending == 0) {
+                wakeIdle(true);
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (unsigned i = 1; i < workers; ++i) {
+        threads.emplace_back(worker, i);
+    }
+    worker(0);
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    ScanResult merged;
+    for (auto &result : results) {
+        merged.solutions.insert(merged.solutions.end(),
+                                std::make_move_iterator(result.solutions.begin()),
+                                std::make_move_iterator(result.solutions.end()));
+        merged.targets.insert(merged.targets.end(),
+                              std::make_move_iterator(result.targets.begin()),
+                              std::make_move_iterator(result.targets.end()));
+    }
+    std::sort(merged.solutions.begin(), merged.solutions.end());
+    std::sort(merged.targets.begin(), merged.targets.end());
+
+    return merged;
+}
@@ -0,0 +1,50 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2018 George Cave <gcave@stablecoder.ca>
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ */
+
+#ifndef SCAN_HPP
+#define SCAN_HPP
+
+// C++
+#include <string>
+#include <string_view>
+#include <vector>
+
+/// The project files found beneath a directory.
+struct ScanResult {
+    /// .sln and .dsw files
+    std::vector<std::string> solutions;
+    /// .vcxproj, .vcproj, .vfproj and .dsp files
+    std::vector<std::string> targets;
+};
+
+/// Walks a directory tree looking for solution and project files. Directories
+/// are spread across threads, with idle threads stealing pending directories
+/// from busy ones. Hidden directories and symlinked directories are skipped.
+/// \param rootDir The directory to start from.
+/// \param threadCount The number of threads to use, 0 for the hardware concurrency.
+/// \return The files found, each list sorted.
+ScanResult scanDirectory(std::string_view rootDir, unsigned threadCount = 0);
+
+#endif // SCAN_HPP
@@ -0,0 +1,268 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2018 George Cave <gcave@stablecoder.ca>
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ */
+
+#include "shared_sources.hpp"
+
+// cmkizer
+#include "config_pool.hpp"
+#include "generators.hpp"
+#include "util.hpp"
+
+// C++
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <map>
+#include <set>
+#include <unordered_map>
+
+namespace {
+
+/// How a target compiles its sources, with paths made relative to the project.
+struct CompileSettings {
+    std::vector<std::pair<std::string, TargetConfig>> configs;
+    std::vector<std::string> precompileHeaders;
+    int useMFC{0};
+    std::size_t hash{0};
+
+    bool operator==(CompileSettings const &other) const {
+        return useMFC == other.useMFC && precompileHeaders == other.precompileHeaders &&
+               std::equal(configs.begin(), configs.end(), other.configs.begin(),
+                          other.configs.end(), [](auto const &lhs, auto const &rhs) {
+                              return lhs.first == rhs.first &&
+                                     sameSettings(lhs.second, rhs.second);
+                          });
+    }
+};
+
+/// Determines the settings that the sources of a target are compiled with.
+CompileSettings compileSettings(ProjectData const &data, TargetData const &target) {
+    auto const directory = targetDirectory(target);
+    CompileSettings settings;
+    settings.useMFC = target.useMFC;
+    for (auto const &header : target.precompileHeaders) {
+        settings.precompileHeaders.emplace_back(
+            header.front() == '<' ? header : rebasePath(directory, header));
+    }
+
+    for (auto const &[name, sharedConfig] : target.configs) {
+        auto config = *sharedConfig;
+        for (auto &includeDir : config.includeDirs) {
+            includeDir = rebasePath(directory, includeDir);
+        }
+        auto const header = precompiledHeaderFile(target, config);
+        config.precompiledHeader =
+            (header == config.precompiledHeader) ? header : rebasePath(directory, header);
+
+        // Only the common target affects compiling, the rest is linking.
+        bool const common = !data.commonTarget.empty() &&
+                            std::find(config.linkLibraries.begin(), config.linkLibraries.end(),
+                                      data.commonTarget) != config.linkLibraries.end();
+        config.linkLibraries.clear();
+        config.linkDirs.clear();
+        if (common) {
+            config.linkLibraries.emplace_back(data.commonTarget);
+        }
+
+        settings.hash = settings.hash * 31 + std::hash<std::string>{}(name) + hashConfig(config);
+        settings.configs.emplace_back(name, std::move(config));
+    }
+    return settings;
+}
+
+/// \return 1 for C sources, 2 for C++ sources, otherwise 0.
+int sourceLanguage(std::string const &file) {
+    auto const lastDot = file.find_last_of('.');
+    if (lastDot == std::string::npos) {
+        return 0;
+    }
+    std::string ext = file.substr(lastDot + 1);
+    std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+    if (ext == "c") {
+        return 1;
+    }
+    return (ext == "cpp" || ext == "cxx" || ext == "cc" || ext == "c++") ? 2 : 0;
+}
+
+/// A listing of a source by one of the targets.
+struct Listing {
+    std::size_t target;
+    std::string file;
+};
+
+} // namespace
+
+std::size_t shareCommonSources(ProjectData &data) {
+    // Group the targets that compile sources the same way.
+    std::vector<CompileSettings> settings(data.targets.size());
+    std::unordered_multimap<std::size_t, std::size_t> classIndices;
+    std::vector<std::vector<std::size_t>> classes;
+    for (std::size_t i = 0; i < data.targets.size(); ++i) {
+        auto const &target = data.targets[i];
+        if (target.useQt || target.isObjectLibrary || target.configs.empty()) {
+            continue;
+        }
+        settings[i] = compileSettings(data, target);
+
+        auto [begin, end] = classIndices.equal_range(settings[i].hash);
+        auto it = std::find_if(begin, end, [&](auto const &entry) {
+            return settings[classes[entry.second].front()] == settings[i];
+        });
+        if (it == end) {
+            classIndices.emplace(settings[i].hash, classes.size());
+            classes.emplace_back(1, i);
+        } else {
+            classes[it->second].emplace_back(i);
+        }
+    }
+
+    // Within each group, the sources listed by more than one target, kept
+    // together by the targets listing them.
+    std::map<std::vector<std::size_t>, std::vector<std::vector<Listing>>> shared;
+    for (auto const &targets : classes) {
+        if (targets.size() < 2) {
+            continue;
+        }
+        std::map<std::string, std::vector<Listing>> listings;
+        for (auto idx : targets) {
+            auto const directory = targetDirectory(data.targets[idx]);
+            for (auto const &[name, filter] : data.targets[idx].filters) {
+                for (auto const &file : filter.files) {
+                    if (sourceLanguage(file) != 0) {
+                        auto &fileListings = listings[rebasePath(directory, file)];
+                        if (fileListings.empty() || fileListings.back().target != idx) {
+                            fileListings.push_back({idx, file});
+                        }
+                    }
+                }
+            }
+        }
+        for (auto &[path, fileListings] : listings) {
+            if (fileListings.size() < 2) {
+                continue;
+            }
+            std::vector<std::size_t> consumers;
+            for (auto const &listing : fileListings) {
+                consumers.emplace_back(listing.target);
+            }
+            shared[consumers].emplace_back(std::move(fileListings));
+        }
+    }
+
+    std::set<std::string> names;
+    for (auto const &target : data.targets) {
+        names.insert(target.name);
+    }
+    std::string baseName = data.name.empty() ? data.targets.front().name : data.name;
+    std::replace(baseName.begin(), baseName.end(), ' ', '_');
+
+    std::size_t suffix = 0;
+    for (auto &[consumers, sources] : shared) {
+        std::string name;
+        do {
+            name = baseName + "_objects_" + std::to_string(++suffix);
+        } while (names.count(name) != 0);
+
+        // Placed with, and compiled as, the first of the targets.
+        auto const &first = data.targets[consumers.front()];
+        TargetData library;
+        library.name = name;
+        library.displayName = name;
+        library.fullPath = first.fullPath;
+        library.relativePath = first.relativePath;
+        library.precompileHeaders = first.precompileHeaders;
+        library.isLibrary = true;
+        library.isObjectLibrary = true;
+        library.useMFC = first.useMFC;
+        auto compiled = settings[consumers.front()].configs.begin();
+        for (auto const &[configName, sharedConfig] : first.configs) {
+            auto &config = library.configs[configName].edit();
+            config = *sharedConfig;
+            config.precompiledHeader = precompiledHeaderFile(first, config);
+            config.linkLibraries = (compiled++)->second.linkLibraries;
+            config.linkDirs.clear();
+        }
+        library.allFiles = PathList(data.pathTable);
+        auto &filter = library.filters["Source Files"];
+        filter.files = PathList(data.pathTable);
+        filter.sources = true;
+        for (auto const &fileListings : sources) {
+            auto const &file = fileListings.front().file;
+            filter.files.emplace_back(file);
+            if (sourceLanguage(file) == 1) {
+                library.enableC = true;
+            } else {
+                library.enableCXX = true;
+            }
+        }
+
+        // The targets link it instead of compiling the sources.
+        auto const libraryIdx = data.targets.size();
+        for (auto consumer : consumers) {
+            auto &target = data.targets[consumer];
+            library.positionIndependent = library.positionIndependent || target.isLibrary;
+            std::set<std::string> removed;
+            for (auto const &fileListings : sources) {
+                for (auto const &listing : fileListings) {
+                    if (listing.target == consumer) {
+                        removed.insert(listing.file);
+                    }
+                }
+            }
+            for (auto &[filterName, targetFilter] : target.filters) {
+                auto &files = targetFilter.files;
+                files.removeIf([&](PathList::Entry const &entry) {
+                    return removed.count(files.path(entry)) != 0;
+                });
+            }
+            for (auto &[configName, config] : target.configs) {
+                config.edit().linkLibraries.emplace_back(name);
+            }
+        }
+
+        std::string consumerNames;
+        for (auto consumer : consumers) {
+            consumerNames += (consumerNames.empty() ? "" : ", ") + data.targets[consumer].name;
+        }
+        data.diagnostics.emplace_back("Warning: Sources shared by " + consumerNames +
+                                      " are compiled once, as " + name + " - " +
+                                      std::to_string(sources.size()) + " files");
+
+        names.insert(name);
+        data.targets.emplace_back(std::move(library));
+        if (data.dependencyGraph.dependencies.size() == libraryIdx) {
+            data.dependencyGraph.dependencies.emplace_back();
+            data.dependencyGraph.dependents.emplace_back(consumers);
+            for (auto consumer : consumers) {
+                data.dependencyGraph.dependencies[consumer].emplace_back(libraryIdx);
+            }
+        }
+    }
+
+    if (!shared.empty()) {
+        shareIdenticalConfigs(data);
+    }
+    return shared.size();
+}
@@ -0,0 +1,51 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2018 George Cave <gcave@stablecoder.ca>
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ */
+
+#ifndef SHARED_SOURCES_HPP
+#define SHARED_SOURCES_HPP
+
+// cmkizer
+#include "type_defs.hpp"
+
+// C++
+#include <cstddef>
+
+/// Finds C and C++ sources that several targets compile with identical
+/// settings, and moves them into OBJECT libraries that the targets link
+/// instead, so each is compiled once.
+///
+/// Targets compile a source the same way when they have the same
+/// configurations, with the same definitions, include directories (relative
+/// to the project), precompiled header and code generation settings, and
+/// either all or none link the common settings target. Sources are matched by
+/// their path relative to the project. Each distinct set of targets sharing
+/// sources gets one OBJECT library, placed alongside the first of them, which
+/// is given that target's compile settings. Qt targets are left alone, their
+/// sources may need the target's own generated code.
+/// \param data The project to process, after preprocessing.
+/// \return The number of OBJECT libraries added.
+std::size_t shareCommonSources(ProjectData &data);
+
+#endif // SHARED_SOURCES_HPP
@@ -31,13 +31,14 @@
 // C++
 #include <algorithm>
 #include <cstring>
-#include <fstream>
+#include <sstream>
 
-std::tuple<bool, ProjectData> slnProjectParse(std::string_view projectPath) {
-    std::ifstream inFile(projectPath.data(), std::ios::in);
-    if (!inFile) {
-        return std::make_tuple(false, ProjectData());
-    }
+std::tuple<bool, ProjectData> slnProjectParse(std::string_view projectPath,
+                                              std::string_view contents,
+                                              FileReader const &readFile,
+                                              TargetCallback const &onTarget,
+                                              TargetSelection const &selection) {
+    std::istringstream inFile(std::string{contents});
 
     ProjectData data;
     const auto lastSlash(std::min(projectPath.find_last_of('\\'), projectPath.find_last_of('/')));
@@ -54,29 +55,28 @@ std::tuple<bool, ProjectData> slnProjectParse(std::string_view projectPath) {
     }
     data.path = projectPath;
 
+    // The project table is read in full first, so only the targets needed
+    // have to be parsed.
+    std::vector<ProjectEntry> entries;
     bool dependencyMode = false;
-    TargetData *activeTarget = nullptr;
+    ProjectEntry *activeEntry = nullptr;
 
     while (!inFile.eof()) {
         std::string line;
         std::getline(inFile, line);
 
         if (line.find("EndProject") != std::string::npos) {
-            activeTarget = nullptr;
+            activeEntry = nullptr;
             dependencyMode = false;
         } else if (dependencyMode) {
-            if (line.find("EndProjectSection") != std::string::npos) {
-                dependencyMode = false;
-            } else {
-                const auto start = line.find_first_of('{');
-                const auto end = line.find_first_of('}');
-
-                if (start != std::string::npos && end != std::string::npos) {
-                    activeTarget->dependencies.emplace_back(line.substr(start, (end + 1) - start));
-                }
+            const auto start = line.find_first_of('{');
+            const auto end = line.find_first_of('}');
+
+            if (start != std::string::npos && end != std::string::npos) {
+                activeEntry->dependencies.emplace_back(line.substr(start, (end + 1) - start));
             }
         } else if (line.find("ProjectSection(ProjectDependencies)") != std::string::npos &&
-                   activeTarget != nullptr) {
+                   activeEntry != nullptr) {
             // Enter dependency mode, and add dependencies.
             dependencyMode = true;
         } else if (line.find("Project(\"{") != std::string::npos) {
@@ -85,35 +85,29 @@ std::tuple<bool, ProjectData> slnProjectParse(std::string_view projectPath) {
             auto end = line.find('"', ++start);
             std::string name = line.substr(start, end - start);
 
-            if (name == "Solution Items" || (name == "Build" && data.targets.empty())) {
+            if (name == "Solution Items" || (name == "Build" && entries.empty())) {
                 continue;
             }
 
+            ProjectEntry entry;
+            entry.name = name;
+
             start = line.find('"', ++end);
             end = line.find('"', ++start);
-            std::string relativePath = line.substr(start, end - start);
-            std::replace(relativePath.begin(), relativePath.end(), '\\', '/');
-            std::string fullPath = rootPath + relativePath;
-
-            auto [read, target] = parseTarget(fullPath);
-
-            if (!read) {
-                printf("Error: Could not parse project file - %s\n", relativePath.data());
-                continue;
-            }
-
-            target.name = name;
-            target.relativePath = relativePath;
+            entry.relativePath = line.substr(start, end - start);
+            std::replace(entry.relativePath.begin(), entry.relativePath.end(), '\\', '/');
+            entry.fullPath = rootPath + entry.relativePath;
 
             start = line.find('"', ++end);
             end = line.find('"', ++start);
-            target.displayName = line.substr(start, end - start);
+            entry.displayName = line.substr(start, end - start);
 
-            data.targets.emplace_back(target);
-
-            activeTarget = &*(data.targets.end() - 1);
+            entries.emplace_back(std::move(entry));
+            activeEntry = &entries.back();
         }
     }
 
+    parseProjectEntries(data, entries, readFile, onTarget, selection);
+
     return std::make_tuple(true, data);
-}
\ No newline at end of file
+}
@@ -35,8 +35,17 @@
 
 /// Parses a vcproj or sln project file.
 /// \param projectPath The path of the file to parse.
+/// \param contents The contents of the file.
+/// \param readFile Provides the referenced target files.
 /// \return A boolean representing the parse success, and the associated parsed
 /// ProjectData.
-std::tuple<bool, ProjectData> slnProjectParse(std::string_view projectPath);
+/// \param onTarget If set, receives each target as soon as it is parsed.
+/// \param selection If not empty, only these targets and their dependencies
+/// are parsed.
+std::tuple<bool, ProjectData> slnProjectParse(std::string_view projectPath,
+                                              std::string_view contents,
+                                              FileReader const &readFile,
+                                              TargetCallback const &onTarget = {},
+                                              TargetSelection const &selection = {});
 
 #endif // SLN_HPP
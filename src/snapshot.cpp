@@ -0,0 +1,471 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2018 George Cave <gcave@stablecoder.ca>
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ */
+
+#include "snapshot.hpp"
+
+// cmkizer
+#include "config_pool.hpp"
+
+// C++
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#if defined(_WIN32)
+#define SNAPSHOT_NO_MMAP
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+TargetConfig const &settingsOf(TargetConfig const &config) { return config; }
+TargetConfig const &settingsOf(SharedConfig const &config) { return *config; }
+
+/// Accumulates the arrays of a snapshot before it is written out.
+struct SnapshotWriter {
+    std::vector<SnapshotString> strings;
+    std::string stringData;
+    std::unordered_map<std::string, std::uint32_t> stringIndices;
+    std::vector<std::uint32_t> indices;
+    std::vector<SnapshotTarget> targets;
+    std::vector<SnapshotConfig> configs;
+    std::vector<SnapshotFilter> filters;
+
+    std::uint32_t intern(std::string const &str) {
+        auto [it, inserted] =
+            stringIndices.try_emplace(str, static_cast<std::uint32_t>(strings.size()));
+        if (inserted) {
+            strings.push_back({static_cast<std::uint32_t>(stringData.size()),
+                               static_cast<std::uint32_t>(str.size())});
+            stringData += str;
+            stringData += '\0';
+        }
+        return it->second;
+    }
+
+    SnapshotRange internList(std::vector<std::string> const &list) {
+        SnapshotRange range{static_cast<std::uint32_t>(indices.size()),
+                            static_cast<std::uint32_t>(list.size())};
+        for (auto const &str : list) {
+            indices.emplace_back(intern(str));
+        }
+        return range;
+    }
+
+    SnapshotRange indexList(std::vector<std::size_t> const &list) {
+        SnapshotRange range{static_cast<std::uint32_t>(indices.size()),
+                            static_cast<std::uint32_t>(list.size())};
+        for (auto idx : list) {
+            indices.emplace_back(static_cast<std::uint32_t>(idx));
+        }
+        return range;
+    }
+
+    template <typename Config>
+    SnapshotRange addConfigs(std::map<std::string, Config> const &configMap) {
+        SnapshotRange range{static_cast<std::uint32_t>(configs.size()),
+                            static_cast<std::uint32_t>(configMap.size())};
+        for (auto const &[name, value] : configMap) {
+            TargetConfig const &config = settingsOf(value);
+            SnapshotConfig record{};
+            record.name = intern(name);
+            record.definitions = internList(config.definitions);
+            record.includeDirs = internList(config.includeDirs);
+            record.linkLibraries = internList(config.linkLibraries);
+            record.linkDirs = internList(config.linkDirs);
+            record.precompiledHeader = intern(config.precompiledHeader);
+            record.optimization = intern(config.optimization);
+            record.enhancedInstructionSet = intern(config.enhancedInstructionSet);
+            record.flags = (config.multiProcessorCompilation ? 1u : 0u) |
+                           (config.wholeProgramOptimization ? 2u : 0u) |
+                           (config.intrinsicFunctions ? 4u : 0u) |
+                           (config.functionLevelLinking ? 8u : 0u);
+            configs.push_back(record);
+        }
+        return range;
+    }
+};
+
+bool inBounds(std::size_t size, std::uint32_t offset, std::uint32_t count, std::size_t stride) {
+    return offset <= size && count <= (size - offset) / stride;
+}
+
+} // namespace
+
+ModelSnapshot::ModelSnapshot(ModelSnapshot &&other) noexcept :
+    data(other.data),
+    size(other.size),
+    owned(other.owned) {
+    other.data = nullptr;
+    other.size = 0;
+}
+
+ModelSnapshot &ModelSnapshot::operator=(ModelSnapshot &&other) noexcept {
+    if (this != &other) {
+        this->~ModelSnapshot();
+        data = other.data;
+        size = other.size;
+        owned = other.owned;
+        other.data = nullptr;
+        other.size = 0;
+    }
+    return *this;
+}
+
+ModelSnapshot::~ModelSnapshot() {
+    if (data == nullptr) {
+        return;
+    }
+#if !defined(SNAPSHOT_NO_MMAP)
+    if (!owned) {
+        munmap(const_cast<std::byte *>(data), size);
+        return;
+    }
+#endif
+    delete[] data;
+}
+
+std::string_view ModelSnapshot::string(std::uint32_t idx) const noexcept {
+    auto const &entry =
+        reinterpret_cast<SnapshotString const *>(data + header().stringsOffset)[idx];
+    return {reinterpret_cast<char const *>(data + header().stringDataOffset + entry.offset),
+            entry.length};
+}
+
+std::uint32_t const *ModelSnapshot::indices(SnapshotRange range) const noexcept {
+    return reinterpret_cast<std::uint32_t const *>(data + header().indicesOffset) + range.first;
+}
+
+SnapshotTarget const *ModelSnapshot::targets() const noexcept {
+    return reinterpret_cast<SnapshotTarget const *>(data + header().targetsOffset);
+}
+
+SnapshotConfig const *ModelSnapshot::configs() const noexcept {
+    return reinterpret_cast<SnapshotConfig const *>(data + header().configsOffset);
+}
+
+SnapshotFilter const *ModelSnapshot::filters() const noexcept {
+    return reinterpret_cast<SnapshotFilter const *>(data + header().filtersOffset);
+}
+
+bool dumpModel(ProjectData const &data,
+               GlobalSettings const &globalSettings,
+               std::string_view path) {
+    SnapshotWriter writer;
+    SnapshotHeader header{};
+    header.magic = cSnapshotMagic;
+    header.version = cSnapshotVersion;
+    header.qtVersion = globalSettings.qtVersion;
+    header.name = writer.intern(data.name);
+    header.path = writer.intern(data.path);
+    header.commonTarget = writer.intern(data.commonTarget);
+    header.commonConfigs = writer.addConfigs(data.commonConfigs);
+
+    for (std::size_t i = 0; i < data.targets.size(); ++i) {
+        auto const &target = data.targets[i];
+        SnapshotTarget record{};
+        record.name = writer.intern(target.name);
+        record.displayName = writer.intern(target.displayName);
+        record.fullPath = writer.intern(target.fullPath);
+        record.relativePath = writer.intern(target.relativePath);
+        record.allFiles = writer.internList(target.allFiles.paths());
+        record.dependencies = writer.internList(target.dependencies);
+        record.precompileHeaders = writer.internList(target.precompileHeaders);
+        std::vector<std::size_t> groupSizes;
+        std::vector<std::string> groupFiles;
+        for (auto const &group : target.unityGroups) {
+            groupSizes.emplace_back(group.size());
+            groupFiles.insert(groupFiles.end(), group.begin(), group.end());
+        }
+        record.unityGroupSizes = writer.indexList(groupSizes);
+        record.unityFiles = writer.internList(groupFiles);
+        record.configs = writer.addConfigs(target.configs);
+
+        record.filters = {static_cast<std::uint32_t>(writer.filters.size()),
+                          static_cast<std::uint32_t>(target.filters.size())};
+        for (auto const &[name, filter] : target.filters) {
+            SnapshotFilter filterRecord{};
+            filterRecord.name = writer.intern(name);
+            filterRecord.files = writer.internList(filter.files.paths());
+            filterRecord.flags = (filter.sources ? 1u : 0u) | (filter.objects ? 2u : 0u);
+            writer.filters.push_back(filterRecord);
+        }
+
+        if (i < data.dependencyGraph.dependencies.size()) {
+            record.dependencyTargets = writer.indexList(data.dependencyGraph.dependencies[i]);
+            record.dependentTargets = writer.indexList(data.dependencyGraph.dependents[i]);
+        }
+
+        record.flags = (target.enableC ? 1u : 0u) | (target.enableCXX ? 2u : 0u) |
+                       (target.enableFortran ? 4u : 0u) | (target.isLibrary ? 8u : 0u) |
+                       (target.useQt ? 16u : 0u) | (target.isObjectLibrary ? 32u : 0u) |
+                       (target.positionIndependent ? 64u : 0u);
+        record.useMFC = target.useMFC;
+        writer.targets.push_back(record);
+    }
+
+    // Lay out the arrays after the header, with the string data last.
+    while (writer.stringData.size() % 4 != 0) {
+        writer.stringData += '\0';
+    }
+    std::size_t offset = sizeof(SnapshotHeader);
+    auto place = [&offset](std::uint32_t &arrayOffset, std::uint32_t &count, std::size_t entries,
+                           std::size_t stride) {
+        arrayOffset = static_cast<std::uint32_t>(offset);
+        count = static_cast<std::uint32_t>(entries);
+        offset += entries * stride;
+    };
+    place(header.stringsOffset, header.stringCount, writer.strings.size(),
+          sizeof(SnapshotString));
+    place(header.indicesOffset, header.indexCount, writer.indices.size(), sizeof(std::uint32_t));
+    place(header.targetsOffset, header.targetCount, writer.targets.size(),
+          sizeof(SnapshotTarget));
+    place(header.configsOffset, header.configCount, writer.configs.size(),
+          sizeof(SnapshotConfig));
+    place(header.filtersOffset, header.filterCount, writer.filters.size(),
+          sizeof(SnapshotFilter));
+    place(header.stringDataOffset, header.stringDataSize, writer.stringData.size(), 1);
+    header.size = static_cast<std::uint32_t>(offset);
+
+    FILE *pOut = fopen(std::string(path).c_str(), "wb");
+    if (pOut == nullptr) {
+        return false;
+    }
+    fwrite(&header, sizeof(header), 1, pOut);
+    fwrite(writer.strings.data(), sizeof(SnapshotString), writer.strings.size(), pOut);
+    fwrite(writer.indices.data(), sizeof(std::uint32_t), writer.indices.size(), pOut);
+    fwrite(writer.targets.data(), sizeof(SnapshotTarget), writer.targets.size(), pOut);
+    fwrite(writer.configs.data(), sizeof(SnapshotConfig), writer.configs.size(), pOut);
+    fwrite(writer.filters.data(), sizeof(SnapshotFilter), writer.filters.size(), pOut);
+    fwrite(writer.stringData.data(), 1, writer.stringData.size(), pOut);
+    bool const success = ferror(pOut) == 0;
+    fclose(pOut);
+
+    return success;
+}
+
+std::tuple<bool, ModelSnapshot> mapModel(std::string_view path) {
+    ModelSnapshot snapshot;
+    std::string filePath(path);
+
+#if defined(SNAPSHOT_NO_MMAP)
+    std::ifstream inFile(filePath, std::ios::in | std::ios::binary | std::ios::ate);
+    if (!inFile) {
+        return std::make_tuple(false, std::move(snapshot));
+    }
+    snapshot.size = static_cast<std::size_t>(inFile.tellg());
+    auto *buffer = new std::byte[snapshot.size];
+    inFile.seekg(0);
+    inFile.read(reinterpret_cast<char *>(buffer), snapshot.size);
+    snapshot.data = buffer;
+    snapshot.owned = true;
+#else
+    int fd = open(filePath.c_str(), O_RDONLY);
+    if (fd == -1) {
+        return std::make_tuple(false, std::move(snapshot));
+    }
+    struct stat fileStat {};
+    if (fstat(fd, &fileStat) != 0 || fileStat.st_size == 0) {
+        close(fd);
+        return std::make_tuple(false, std::move(snapshot));
+    }
+    void *mapping = mmap(nullptr, fileStat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        return std::make_tuple(false, std::move(snapshot));
+    }
+    snapshot.data = static_cast<std::byte const *>(mapping);
+    snapshot.size = static_cast<std::size_t>(fileStat.st_size);
+#endif
+
+    // Only the layout is checked here, the contents are checked when loaded.
+    if (snapshot.size < sizeof(SnapshotHeader)) {
+        return std::make_tuple(false, std::move(snapshot));
+    }
+    auto const &header = snapshot.header();
+    bool valid =
+        header.magic == cSnapshotMagic && header.version == cSnapshotVersion &&
+        header.size == snapshot.size &&
+        inBounds(snapshot.size, header.stringsOffset, header.stringCount,
+                 sizeof(SnapshotString)) &&
+        inBounds(snapshot.size, header.indicesOffset, header.indexCount,
+                 sizeof(std::uint32_t)) &&
+        inBounds(snapshot.size, header.targetsOffset, header.targetCount,
+                 sizeof(SnapshotTarget)) &&
+        inBounds(snapshot.size, header.configsOffset, header.configCount,
+                 sizeof(SnapshotConfig)) &&
+        inBounds(snapshot.size, header.filtersOffset, header.filterCount,
+                 sizeof(SnapshotFilter)) &&
+        inBounds(snapshot.size, header.stringDataOffset, header.stringDataSize, 1);
+
+    return std::make_tuple(valid, std::move(snapshot));
+}
+
+std::tuple<bool, ProjectData> loadModel(ModelSnapshot const &snapshot,
+                                        GlobalSettings &globalSettings) {
+    ProjectData data;
+    auto const &header = snapshot.header();
+    bool valid = true;
+
+    auto string = [&](std::uint32_t idx) -> std::string {
+        if (idx >= header.stringCount) {
+            valid = false;
+            return {};
+        }
+        auto const &entry = reinterpret_cast<SnapshotString const *>(
+            reinterpret_cast<std::byte const *>(&header) + header.stringsOffset)[idx];
+        if (entry.offset > header.stringDataSize ||
+            entry.length >= header.stringDataSize - entry.offset) {
+            valid = false;
+            return {};
+        }
+        return std::string(snapshot.string(idx));
+    };
+    auto rangeValid = [&](SnapshotRange range, std::uint32_t limit) {
+        valid = valid && range.first <= limit && range.count <= limit - range.first;
+        return valid;
+    };
+    auto stringList = [&](SnapshotRange range) {
+        std::vector<std::string> list;
+        if (rangeValid(range, header.indexCount)) {
+            auto const *indices = snapshot.indices(range);
+            list.reserve(range.count);
+            for (std::uint32_t i = 0; i < range.count; ++i) {
+                list.emplace_back(string(indices[i]));
+            }
+        }
+        return list;
+    };
+    auto indexList = [&](SnapshotRange range) {
+        std::vector<std::size_t> list;
+        if (rangeValid(range, header.indexCount)) {
+            auto const *indices = snapshot.indices(range);
+            for (std::uint32_t i = 0; i < range.count; ++i) {
+                valid = valid && indices[i] < header.targetCount;
+                list.emplace_back(indices[i]);
+            }
+        }
+        return list;
+    };
+    auto configMap = [&](SnapshotRange range) {
+        std::map<std::string, TargetConfig> configs;
+        if (!rangeValid(range, header.configCount)) {
+            return configs;
+        }
+        for (std::uint32_t i = range.first; i < range.first + range.count; ++i) {
+            auto const &record = snapshot.configs()[i];
+            auto &config = configs[string(record.name)];
+            config.definitions = stringList(record.definitions);
+            config.includeDirs = stringList(record.includeDirs);
+            config.linkLibraries = stringList(record.linkLibraries);
+            config.linkDirs = stringList(record.linkDirs);
+            config.precompiledHeader = string(record.precompiledHeader);
+            config.optimization = string(record.optimization);
+            config.enhancedInstructionSet = string(record.enhancedInstructionSet);
+            config.multiProcessorCompilation = (record.flags & 1u) != 0;
+            config.wholeProgramOptimization = (record.flags & 2u) != 0;
+            config.intrinsicFunctions = (record.flags & 4u) != 0;
+            config.functionLevelLinking = (record.flags & 8u) != 0;
+        }
+        return configs;
+    };
+
+    data.name = string(header.name);
+    data.path = string(header.path);
+    data.commonTarget = string(header.commonTarget);
+    data.commonConfigs = configMap(header.commonConfigs);
+
+    data.targets.resize(header.targetCount);
+    data.dependencyGraph.dependencies.resize(header.targetCount);
+    data.dependencyGraph.dependents.resize(header.targetCount);
+    for (std::uint32_t i = 0; i < header.targetCount && valid; ++i) {
+        auto const &record = snapshot.targets()[i];
+        auto &target = data.targets[i];
+
+        target.name = string(record.name);
+        target.displayName = string(record.displayName);
+        target.fullPath = string(record.fullPath);
+        target.relativePath = string(record.relativePath);
+        target.allFiles = PathList(stringList(record.allFiles), data.pathTable);
+        target.dependencies = stringList(record.dependencies);
+        target.precompileHeaders = stringList(record.precompileHeaders);
+        auto groupFiles = stringList(record.unityFiles);
+        if (rangeValid(record.unityGroupSizes, header.indexCount)) {
+            auto const *sizes = snapshot.indices(record.unityGroupSizes);
+            std::size_t next = 0;
+            for (std::uint32_t g = 0; g < record.unityGroupSizes.count && valid; ++g) {
+                valid = sizes[g] <= groupFiles.size() - next;
+                if (valid) {
+                    target.unityGroups.emplace_back(
+                        std::make_move_iterator(groupFiles.begin() + next),
+                        std::make_move_iterator(groupFiles.begin() + next + sizes[g]));
+                    next += sizes[g];
+                }
+            }
+            valid = valid && next == groupFiles.size();
+        }
+        for (auto &[name, config] : configMap(record.configs)) {
+            target.configs.emplace(name, std::move(config));
+        }
+
+        if (rangeValid(record.filters, header.filterCount)) {
+            for (std::uint32_t f = record.filters.first;
+                 f < record.filters.first + record.filters.count; ++f) {
+                auto const &filterRecord = snapshot.filters()[f];
+                auto &filter = target.filters[string(filterRecord.name)];
+                filter.files = PathList(stringList(filterRecord.files), data.pathTable);
+                filter.sources = (filterRecord.flags & 1u) != 0;
+                filter.objects = (filterRecord.flags & 2u) != 0;
+            }
+        }
+
+        data.dependencyGraph.dependencies[i] = indexList(record.dependencyTargets);
+        data.dependencyGraph.dependents[i] = indexList(record.dependentTargets);
+
+        target.enableC = (record.flags & 1u) != 0;
+        target.enableCXX = (record.flags & 2u) != 0;
+        target.enableFortran = (record.flags & 4u) != 0;
+        target.isLibrary = (record.flags & 8u) != 0;
+        target.useQt = (record.flags & 16u) != 0;
+        target.isObjectLibrary = (record.flags & 32u) != 0;
+        target.positionIndependent = (record.flags & 64u) != 0;
+        target.useMFC = record.useMFC;
+    }
+
+    if (globalSettings.qtVersion == 0) {
+        globalSettings.qtVersion = header.qtVersion;
+    }
+    shareIdenticalConfigs(data);
+
+    return std::make_tuple(valid, data);
+}
@@ -0,0 +1,188 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2018 George Cave <gcave@stablecoder.ca>
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ */
+
+#ifndef SNAPSHOT_HPP
+#define SNAPSHOT_HPP
+
+// cmkizer
+#include "type_defs.hpp"
+
+// C++
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <tuple>
+
+/// Model snapshots are a relocatable binary image of a preprocessed ProjectData.
+///
+/// Everything is stored as native-endian 32-bit values, with all strings
+/// interned into a single string table, and all lists stored as ranges into a
+/// shared index pool. Offsets are relative to the start of the file, so the
+/// file can be memory-mapped and read in place without any parsing.
+
+constexpr std::uint32_t cSnapshotMagic = 0x5a4b4d43; // 'CMKZ'
+constexpr std::uint32_t cSnapshotVersion = 4;
+
+/// A range of entries within one of the snapshot's arrays.
+struct SnapshotRange {
+    std::uint32_t first;
+    std::uint32_t count;
+};
+
+/// The location of a NUL-terminated string within the string data.
+struct SnapshotString {
+    std::uint32_t offset;
+    std::uint32_t length;
+};
+
+struct SnapshotFilter {
+    /// String index of the filter name
+    std::uint32_t name;
+    /// String indices of the files, from the index pool
+    SnapshotRange files;
+    /// Bit 0 - sources, bit 1 - objects
+    std::uint32_t flags;
+};
+
+struct SnapshotConfig {
+    /// String index of the config name
+    std::uint32_t name;
+    /// String indices, from the index pool
+    SnapshotRange definitions;
+    SnapshotRange includeDirs;
+    SnapshotRange linkLibraries;
+    SnapshotRange linkDirs;
+    /// String indices
+    std::uint32_t precompiledHeader;
+    std::uint32_t optimization;
+    std::uint32_t enhancedInstructionSet;
+    /// Bit 0 - multiProcessorCompilation, bit 1 - wholeProgramOptimization,
+    /// bit 2 - intrinsicFunctions, bit 3 - functionLevelLinking
+    std::uint32_t flags;
+};
+
+struct SnapshotTarget {
+    /// String indices
+    std::uint32_t name;
+    std::uint32_t displayName;
+    std::uint32_t fullPath;
+    std::uint32_t relativePath;
+    /// String indices, from the index pool
+    SnapshotRange allFiles;
+    SnapshotRange dependencies;
+    SnapshotRange precompileHeaders;
+    /// File counts of each unity group from the index pool, and the string
+    /// indices of the grouped files in order, from the index pool
+    SnapshotRange unityGroupSizes;
+    SnapshotRange unityFiles;
+    /// Entries of the config and filter arrays
+    SnapshotRange configs;
+    SnapshotRange filters;
+    /// Target indices from the index pool, as in the DependencyGraph
+    SnapshotRange dependencyTargets;
+    SnapshotRange dependentTargets;
+    /// Bit 0 - enableC, bit 1 - enableCXX, bit 2 - enableFortran,
+    /// bit 3 - isLibrary, bit 4 - useQt, bit 5 - isObjectLibrary,
+    /// bit 6 - positionIndependent
+    std::uint32_t flags;
+    std::int32_t useMFC;
+};
+
+struct SnapshotHeader {
+    std::uint32_t magic;
+    std::uint32_t version;
+    /// Size of the whole file, in bytes
+    std::uint32_t size;
+    /// The Qt version determined during preprocessing
+    std::int32_t qtVersion;
+    /// String indices
+    std::uint32_t name;
+    std::uint32_t path;
+    std::uint32_t commonTarget;
+    /// Entries of the config array for the common target
+    SnapshotRange commonConfigs;
+    /// Offsets and counts of each array
+    std::uint32_t stringsOffset;
+    std::uint32_t stringCount;
+    std::uint32_t stringDataOffset;
+    std::uint32_t stringDataSize;
+    std::uint32_t indicesOffset;
+    std::uint32_t indexCount;
+    std::uint32_t targetsOffset;
+    std::uint32_t targetCount;
+    std::uint32_t configsOffset;
+    std::uint32_t configCount;
+    std::uint32_t filtersOffset;
+    std::uint32_t filterCount;
+};
+
+/// A read-only view of a memory-mapped model snapshot.
+class ModelSnapshot {
+  public:
+    ModelSnapshot() = default;
+    ModelSnapshot(ModelSnapshot &&other) noexcept;
+    ModelSnapshot &operator=(ModelSnapshot &&other) noexcept;
+    ModelSnapshot(ModelSnapshot const &) = delete;
+    ModelSnapshot &operator=(ModelSnapshot const &) = delete;
+    ~ModelSnapshot();
+
+    SnapshotHeader const &header() const noexcept {
+        return *reinterpret_cast<SnapshotHeader const *>(data);
+    }
+    std::string_view string(std::uint32_t idx) const noexcept;
+    std::uint32_t const *indices(SnapshotRange range) const noexcept;
+    SnapshotTarget const *targets() const noexcept;
+    SnapshotConfig const *configs() const noexcept;
+    SnapshotFilter const *filters() const noexcept;
+
+  private:
+    friend std::tuple<bool, ModelSnapshot> mapModel(std::string_view path);
+
+    std::byte const *data{nullptr};
+    std::size_t size{0};
+    /// Set if the file was read into memory rather than mapped
+    bool owned{false};
+};
+
+/// Writes a preprocessed project to a model snapshot file.
+/// \param data The project to write.
+/// \param globalSettings The settings the project was preprocessed with.
+/// \param path The file to write to.
+/// \return True if the file was written.
+bool dumpModel(ProjectData const &data, GlobalSettings const &globalSettings, std::string_view path);
+
+/// Maps a model snapshot file into memory.
+/// \param path The file to map.
+/// \return A boolean representing the success, and the mapped snapshot.
+std::tuple<bool, ModelSnapshot> mapModel(std::string_view path);
+
+/// Copies a mapped snapshot back into a ProjectData.
+/// \param snapshot The snapshot to read.
+/// \param globalSettings Receives the Qt version, if not already set.
+/// \return A boolean representing the success, and the ProjectData.
+std::tuple<bool, ProjectData> loadModel(ModelSnapshot const &snapshot,
+                                        GlobalSettings &globalSettings);
+
+#endif // SNAPSHOT_HPP
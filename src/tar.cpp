@@ -0,0 +1,330 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2018 George Cave <gcave@stablecoder.ca>
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ */
+
+#include "tar.hpp"
+
+// cmkizer
+#include "util.hpp"
+
+// C++
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <fstream>
+
+#if defined(_WIN32)
+#define TAR_NO_MMAP
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+constexpr std::size_t cBlockSize = 512;
+
+/// Layout of a ustar header block.
+struct TarHeader {
+    char name[100];
+    char mode[8];
+    char uid[8];
+    char gid[8];
+    char size[12];
+    char mtime[12];
+    char checksum[8];
+    char typeflag;
+    char linkname[100];
+    char magic[6];
+    char version[2];
+    char uname[32];
+    char gname[32];
+    char devmajor[8];
+    char devminor[8];
+    char prefix[155];
+    char padding[12];
+};
+static_assert(sizeof(TarHeader) == cBlockSize);
+
+/// Reads a NUL or space terminated field.
+std::string_view field(char const *text, std::size_t length) {
+    std::string_view value(text, strnlen(text, length));
+    while (!value.empty() && value.back() == ' ') {
+        value.remove_suffix(1);
+    }
+    return value;
+}
+
+/// Reads a numeric field, either octal or GNU base-256 for large values.
+std::uint64_t number(char const *text, std::size_t length) {
+    auto const *bytes = reinterpret_cast<unsigned char const *>(text);
+    std::uint64_t value = 0;
+
+    if ((bytes[0] & 0x80) != 0) {
+        for (std::size_t i = 1; i < length; ++i) {
+            value = (value << 8) | bytes[i];
+        }
+        return value;
+    }
+
+    for (std::size_t i = 0; i < length; ++i) {
+        if (bytes[i] == ' ') {
+            continue;
+        }
+        if (bytes[i] < '0' || bytes[i] > '7') {
+            break;
+        }
+        value = (value << 3) | (bytes[i] - '0');
+    }
+    return value;
+}
+
+bool validChecksum(TarHeader const &header) {
+    auto const *bytes = reinterpret_cast<unsigned char const *>(&header);
+    std::uint64_t sum = 0;
+    for (std::size_t i = 0; i < cBlockSize; ++i) {
+        bool const isChecksum = i >= offsetof(TarHeader, checksum) &&
+                                i < offsetof(TarHeader, checksum) + sizeof(header.checksum);
+        sum += isChecksum ? ' ' : bytes[i];
+    }
+    return sum == number(header.checksum, sizeof(header.checksum));
+}
+
+/// Extracts the 'path' record of a pax extended header.
+std::string paxPath(std::string_view records) {
+    std::string path;
+
+    while (!records.empty()) {
+        auto const space = records.find(' ');
+        if (space == std::string::npos) {
+            break;
+        }
+        std::size_t length = 0;
+        for (char ch : records.substr(0, space)) {
+            length = length * 10 + (ch - '0');
+        }
+        if (length <= space || length > records.size()) {
+            break;
+        }
+
+        // The record is "<length> <key>=<value>\n"
+        std::string_view record = records.substr(space + 1, length - space - 2);
+        if (record.substr(0, 5) == "path=") {
+            path = record.substr(5);
+        }
+        records.remove_prefix(length);
+    }
+
+    return path;
+}
+
+/// \return The normalized path, or an empty string if the path has a root or
+/// leads outside of the archive, which no member may.
+std::string normalizeMemberPath(std::string_view path) {
+    std::string retVal(path);
+    std::replace(retVal.begin(), retVal.end(), '\\', '/');
+    bool const hasDrive = retVal.size() >= 2 && retVal[1] == ':' &&
+                          std::isalpha(static_cast<unsigned char>(retVal[0]));
+    if (retVal.empty() || retVal.front() == '/' || hasDrive) {
+        return {};
+    }
+    retVal = rebasePath("", retVal);
+    if (retVal == ".." || retVal.compare(0, 3, "../") == 0) {
+        return {};
+    }
+    return retVal;
+}
+
+std::string foldCase(std::string path) {
+    std::transform(path.begin(), path.end(), path.begin(), ::tolower);
+    return path;
+}
+
+} // namespace
+
+TarArchive::TarArchive(TarArchive &&other) noexcept :
+    data(other.data),
+    size(other.size),
+    owned(other.owned),
+    paths(std::move(other.paths)),
+    members(std::move(other.members)),
+    foldedPaths(std::move(other.foldedPaths)) {
+    other.data = nullptr;
+    other.size = 0;
+}
+
+TarArchive &TarArchive::operator=(TarArchive &&other) noexcept {
+    if (this != &other) {
+        this->~TarArchive();
+        data = other.data;
+        size = other.size;
+        owned = other.owned;
+        paths = std::move(other.paths);
+        members = std::move(other.members);
+        foldedPaths = std::move(other.foldedPaths);
+        other.data = nullptr;
+        other.size = 0;
+    }
+    return *this;
+}
+
+TarArchive::~TarArchive() {
+    if (data == nullptr) {
+        return;
+    }
+#if !defined(TAR_NO_MMAP)
+    if (!owned) {
+        munmap(const_cast<std::byte *>(data), size);
+        return;
+    }
+#endif
+    delete[] data;
+}
+
+std::tuple<bool, std::string_view> TarArchive::member(std::string_view path) const {
+    std::string normalized = normalizeMemberPath(path);
+    if (normalized.empty()) {
+        return std::make_tuple(false, std::string_view());
+    }
+
+    if (auto it = members.find(normalized); it != members.end()) {
+        return std::make_tuple(true, it->second);
+    }
+    if (auto it = foldedPaths.find(foldCase(normalized)); it != foldedPaths.end()) {
+        return std::make_tuple(true, members.at(it->second));
+    }
+
+    return std::make_tuple(false, std::string_view());
+}
+
+FileReader TarArchive::reader() const {
+    return [this](std::string const &path) {
+        auto [found, contents] = member(path);
+        return std::make_tuple(found, std::string(contents));
+    };
+}
+
+std::tuple<bool, TarArchive> openTar(std::string_view path) {
+    TarArchive archive;
+    std::string filePath(path);
+
+#if defined(TAR_NO_MMAP)
+    std::ifstream inFile(filePath, std::ios::in | std::ios::binary | std::ios::ate);
+    if (!inFile) {
+        return std::make_tuple(false, std::move(archive));
+    }
+    archive.size = static_cast<std::size_t>(inFile.tellg());
+    auto *buffer = new std::byte[archive.size];
+    inFile.seekg(0);
+    inFile.read(reinterpret_cast<char *>(buffer), archive.size);
+    archive.data = buffer;
+    archive.owned = true;
+#else
+    int fd = open(filePath.c_str(), O_RDONLY);
+    if (fd == -1) {
+        return std::make_tuple(false, std::move(archive));
+    }
+    struct stat fileStat {};
+    if (fstat(fd, &fileStat) != 0 || fileStat.st_size == 0) {
+        close(fd);
+        return std::make_tuple(false, std::move(archive));
+    }
+    void *mapping = mmap(nullptr, fileStat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        return std::make_tuple(false, std::move(archive));
+    }
+    archive.data = static_cast<std::byte const *>(mapping);
+    archive.size = static_cast<std::size_t>(fileStat.st_size);
+#endif
+
+    // Only the headers are visited, member contents are skipped over.
+    std::string longName;
+    std::size_t offset = 0;
+    while (offset + cBlockSize <= archive.size) {
+        auto const &header = *reinterpret_cast<TarHeader const *>(archive.data + offset);
+        if (header.name[0] == '\0') {
+            // End of archive marker
+            break;
+        }
+        if (!validChecksum(header)) {
+            return std::make_tuple(false, std::move(archive));
+        }
+
+        std::uint64_t const memberSize = number(header.size, sizeof(header.size));
+        offset += cBlockSize;
+        if (memberSize > archive.size - offset) {
+            return std::make_tuple(false, std::move(archive));
+        }
+        std::string_view contents(reinterpret_cast<char const *>(archive.data + offset),
+                                  static_cast<std::size_t>(memberSize));
+        offset += (memberSize + cBlockSize - 1) / cBlockSize * cBlockSize;
+
+        switch (header.typeflag) {
+        case 'L':
+            // GNU long name for the next member
+            longName = field(contents.data(), contents.size());
+            break;
+        case 'x':
+            // pax extended header for the next member
+            longName = paxPath(contents);
+            break;
+        case '0':
+        case '7':
+        case '\0': {
+            std::string name;
+            if (!longName.empty()) {
+                name = std::move(longName);
+                longName.clear();
+            } else {
+                name = field(header.name, sizeof(header.name));
+                std::string_view prefix = field(header.prefix, sizeof(header.prefix));
+                if (field(header.magic, 5) == "ustar" && !prefix.empty()) {
+                    name = std::string(prefix) + '/' + name;
+                }
+            }
+
+            std::string normalized = normalizeMemberPath(name);
+            if (normalized.empty()) {
+                // Absolute or leading outside the archive, never extracted to.
+                break;
+            }
+            if (archive.members.count(normalized) == 0) {
+                archive.paths.emplace_back(normalized);
+            }
+            archive.foldedPaths[foldCase(normalized)] = normalized;
+            archive.members[std::move(normalized)] = contents;
+            break;
+        }
+        default:
+            // Directories, links and other special members are not needed.
+            longName.clear();
+            break;
+        }
+    }
+
+    return std::make_tuple(true, std::move(archive));
+}
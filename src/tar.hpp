@@ -0,0 +1,86 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2018 George Cave <gcave@stablecoder.ca>
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ */
+
+#ifndef TAR_HPP
+#define TAR_HPP
+
+// cmkizer
+#include "type_defs.hpp"
+
+// C++
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+/// A read-only view of a memory-mapped tar archive, with the regular file
+/// members indexed by their normalized path.
+class TarArchive {
+  public:
+    TarArchive() = default;
+    TarArchive(TarArchive &&other) noexcept;
+    TarArchive &operator=(TarArchive &&other) noexcept;
+    TarArchive(TarArchive const &) = delete;
+    TarArchive &operator=(TarArchive const &) = delete;
+    ~TarArchive();
+
+    /// Finds a member of the archive. Paths are normalized first, and if there
+    /// is no exact match then a case-insensitive match is used, as the project
+    /// files come from case-insensitive filesystems.
+    /// \param path The path of the member, relative to the archive's root.
+    /// \return True and the member's contents if it was found.
+    std::tuple<bool, std::string_view> member(std::string_view path) const;
+
+    /// \return The normalized paths of all regular file members, in archive order.
+    std::vector<std::string> const &memberPaths() const noexcept { return paths; }
+
+    /// \return A FileReader providing members of this archive, which must
+    /// outlive it.
+    FileReader reader() const;
+
+  private:
+    friend std::tuple<bool, TarArchive> openTar(std::string_view path);
+
+    std::byte const *data{nullptr};
+    std::size_t size{0};
+    /// Set if the file was read into memory rather than mapped
+    bool owned{false};
+
+    std::vector<std::string> paths;
+    std::unordered_map<std::string, std::string_view> members;
+    /// Lower-cased path to the actual path
+    std::unordered_map<std::string, std::string> foldedPaths;
+};
+
+/// Maps a tar archive into memory and indexes its members. Supports ustar,
+/// GNU long names and pax extended headers. Members with an absolute path, or
+/// a path leading outside of the archive, are skipped.
+/// \param path The archive to open.
+/// \return A boolean representing the success, and the indexed archive.
+std::tuple<bool, TarArchive> openTar(std::string_view path);
+
+#endif // TAR_HPP
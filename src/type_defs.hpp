@@ -26,15 +26,23 @@
 #ifndef TYPE_DEFS_HPP
 #define TYPE_DEFS_HPP
 
+// cmkizer
+#include "path_table.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
 #include <map>
+#include <memory>
 #include <string>
+#include <tuple>
 #include <vector>
 
 /// A grouping of files together, separated as source, header and resource
 /// files.
 struct FilterGroup {
     /// List of files part of this filter group
-    std::vector<std::string> files;
+    PathList files;
     /// True if there are sources to be compiled within this group
     bool sources{false};
     /// True if there are objects to be linked within this group
@@ -52,6 +60,54 @@ struct TargetConfig {
     std::vector<std::string> linkLibraries;
     /// List of directores containing libraries
     std::vector<std::string> linkDirs;
+    /// The precompiled header used by sources, empty if not used
+    std::string precompiledHeader;
+    /// The optimization level, one of 'Disabled', 'MinSpace', 'MaxSpeed' or 'Full'
+    std::string optimization;
+    /// The enhanced instruction set, such as 'AdvancedVectorExtensions2'
+    std::string enhancedInstructionSet;
+    /// True if sources are compiled with multiple processes (/MP)
+    bool multiProcessorCompilation{false};
+    /// True if whole program optimization (LTCG) is enabled
+    bool wholeProgramOptimization{false};
+    /// True if intrinsic functions are enabled (/Oi)
+    bool intrinsicFunctions{false};
+    /// True if function level linking is enabled (/Gy)
+    bool functionLevelLinking{false};
+};
+
+/// A handle to a TargetConfig. After preprocessing, every configuration with
+/// identical settings, across all targets, refers to one shared instance.
+/// Reading goes straight to the instance, while edit() first gives the handle
+/// its own copy if the instance is shared.
+class SharedConfig {
+  public:
+    SharedConfig() : config(std::make_shared<TargetConfig>()) {}
+    SharedConfig(TargetConfig value) : config(std::make_shared<TargetConfig>(std::move(value))) {}
+
+    TargetConfig const &operator*() const noexcept { return *config; }
+    TargetConfig const *operator->() const noexcept { return config.get(); }
+
+    /// Handles of one instance may be edited from different threads, the fence
+    /// orders the in-place edit after any other handle's copy of the instance.
+    /// \return The config for modification, no longer shared with any other.
+    TargetConfig &edit() {
+        if (config.use_count() > 1) {
+            config = std::make_shared<TargetConfig>(*config);
+        } else {
+            std::atomic_thread_fence(std::memory_order_acquire);
+        }
+        return *config;
+    }
+
+    /// \return True if both handles refer to the same instance.
+    bool sameAs(SharedConfig const &other) const noexcept { return config == other.config; }
+
+    /// Makes this handle refer to the same instance as another.
+    void share(SharedConfig const &other) noexcept { config = other.config; }
+
+  private:
+    std::shared_ptr<TargetConfig> config;
 };
 
 /// A full target's information, including the file's location, the configs,
@@ -61,19 +117,41 @@ struct TargetData {
     std::string displayName;
     std::string fullPath;
     std::string relativePath;
-    /// All the files of the target
-    std::vector<std::string> allFiles;
-    std::map<std::string, TargetConfig> configs;
+    /// All the files of the target. Its table is shared by the files of every
+    /// filter group.
+    PathList allFiles;
+    std::map<std::string, SharedConfig> configs;
     std::map<std::string, FilterGroup> filters;
     std::vector<std::string> dependencies;
+    /// Headers to precompile for every configuration when the configurations
+    /// name none, either '<header>' or a path relative to the target
+    std::vector<std::string> precompileHeaders;
+    /// Sources compiled together by a unity build, as listed in the filter
+    /// groups, empty to not use a unity build
+    std::vector<std::vector<std::string>> unityGroups;
     bool enableC = false;
     bool enableCXX = false;
     bool enableFortran = false;
     bool isLibrary = false;
+    /// True if the target is an OBJECT library of sources shared by other
+    /// targets, which link it instead of compiling them
+    bool isObjectLibrary = false;
+    /// True if the target's objects are linked into a library, which may be
+    /// shared, and so must be position-independent
+    bool positionIndependent = false;
     int useMFC = 0;
     bool useQt = false;
 };
 
+/// The dependencies between a project's targets, as adjacency lists over the
+/// indices of the targets.
+struct DependencyGraph {
+    /// For each target, the targets it depends upon
+    std::vector<std::vector<std::size_t>> dependencies;
+    /// For each target, the targets that depend upon it
+    std::vector<std::vector<std::size_t>> dependents;
+};
+
 /// A full project's information.
 struct ProjectData {
     /// Name of the whole project
@@ -82,15 +160,66 @@ struct ProjectData {
     std::string path;
     /// The set of targets within the project
     std::vector<TargetData> targets;
+    /// The resolved dependencies between the targets
+    DependencyGraph dependencyGraph;
+    /// Name of the INTERFACE target holding settings common to most targets,
+    /// empty if there is none
+    std::string commonTarget;
+    /// The common settings per configuration, include directories are
+    /// relative to the project's path
+    std::map<std::string, TargetConfig> commonConfigs;
+    /// Errors and warnings encountered while parsing and processing
+    std::vector<std::string> diagnostics;
+    /// The directories of the files of every target
+    std::shared_ptr<PathTable> pathTable = std::make_shared<PathTable>();
 };
 
+/// Generated file contents, keyed by the path they are meant to be written to.
+using GeneratedFiles = std::map<std::string, std::string>;
+
+/// Receives each target of a project as soon as it has been fully parsed. When
+/// given to a project parser, the targets are handed over rather than kept
+/// within the returned ProjectData.
+using TargetCallback = std::function<void(TargetData &target)>;
+
+/// Names of the targets to convert, along with everything they depend upon. An
+/// empty selection converts every target.
+using TargetSelection = std::vector<std::string>;
+
+/// Provides the contents of a file referenced by the one being parsed, such as
+/// a solution's projects or a project's '.filters' file. Returns false if the
+/// file is not available.
+using FileReader = std::function<std::tuple<bool, std::string>(std::string const &path)>;
+
 struct GlobalSettings {
     int qtVersion = 0;
     std::string includePath = "include/";
     std::string cmakeVersion = "3.13";
     int cpackType = 0;
+    /// 0 - sources are not checked, 1 - missing sources are reported,
+    /// 2 - missing sources are reported and dropped
+    int verifySources = 0;
+    /// If not empty, only these targets and their dependencies are converted
+    TargetSelection selectedTargets;
+    /// If true, include directories the targets are missing are inferred
+    /// from their sources' includes
+    bool inferIncludes = false;
+    /// 0 - no precompiled headers are inferred, 1 - candidates are reported,
+    /// 2 - candidates are reported and used
+    int inferPch = 0;
+    /// If true, sources compiled with identical settings by several targets
+    /// are compiled once, as an OBJECT library the targets link
+    bool shareSources = false;
+    /// If true, targets are given unity build groups balanced by source size
+    bool unityBuild = false;
+    /// 0 - CMake files are generated, 1 - a build.ninja is generated
+    int backend = 0;
+    /// The configuration used by generators that only handle one, empty for
+    /// each target's first
+    std::string buildConfig;
 };
 
 constexpr const char *cCmakeFilename("CMakeLists.txt");
+constexpr const char *cNinjaFilename("build.ninja");
 
 #endif // TYPE_DEFS_HPP
@@ -0,0 +1,381 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2018 George Cave <gcave@stablecoder.ca>
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ */
+
+#include "unity.hpp"
+
+// cmkizer
+#include "parallel.hpp"
+#include "prefetch.hpp"
+#include "util.hpp"
+
+// C++
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace {
+
+/// Words that may be followed by what otherwise marks a declared name.
+constexpr std::string_view cNotNames[] = {
+    "alignas",  "alignof", "decltype", "noexcept",      "operator", "return",
+    "sizeof",   "static",  "throw",    "static_assert", "typeid",   "__attribute__",
+    "__declspec"};
+
+bool isIdentifierChar(char ch) {
+    return std::isalnum(static_cast<unsigned char>(ch)) || ch == '_';
+}
+
+/// A source to be grouped.
+struct UnitySource {
+    /// The path as listed by the target
+    std::string file;
+    std::string directory;
+    std::size_t bytes;
+    std::vector<std::string> const *pNames;
+};
+
+/// A unity group being built.
+struct UnityGroup {
+    std::vector<std::string> files;
+    std::size_t bytes{0};
+    std::unordered_set<std::string> names;
+
+    bool collides(UnitySource const &source) const {
+        return std::any_of(source.pNames->begin(), source.pNames->end(),
+                           [&](std::string const &name) { return names.count(name) != 0; });
+    }
+
+    void add(UnitySource const &source) {
+        files.emplace_back(source.file);
+        bytes += source.bytes;
+        names.insert(source.pNames->begin(), source.pNames->end());
+    }
+};
+
+/// Groups the sources of one language of a target.
+void groupSources(std::vector<UnitySource> sources,
+                  std::vector<std::vector<std::string>> &unityGroups) {
+    if (sources.size() < 2) {
+        return;
+    }
+    std::sort(sources.begin(), sources.end(), [](auto const &lhs, auto const &rhs) {
+        return std::tie(lhs.directory, lhs.file) < std::tie(rhs.directory, rhs.file);
+    });
+
+    std::size_t total = 0;
+    for (auto const &source : sources) {
+        total += source.bytes;
+    }
+    auto const groupCount =
+        std::max({std::size_t{1}, (total + cUnityGroupBytes - 1) / cUnityGroupBytes,
+                  (sources.size() + cUnityGroupFiles - 1) / cUnityGroupFiles});
+    auto const limit = std::max<std::size_t>(1, total / groupCount);
+
+    // Runs of about equal size, in directory order.
+    std::vector<UnityGroup> groups(1);
+    std::vector<UnitySource const *> deferred;
+    for (auto const &source : sources) {
+        auto *pGroup = &groups.back();
+        if (!pGroup->files.empty() && (pGroup->bytes + source.bytes / 2 > limit ||
+                                       pGroup->files.size() == cUnityGroupFiles)) {
+            pGroup = &groups.emplace_back();
+        }
+        if (pGroup->collides(source)) {
+            deferred.emplace_back(&source);
+        } else {
+            pGroup->add(source);
+        }
+    }
+
+    // Sources that collide go to the smallest group they don't collide with.
+    for (auto const *pSource : deferred) {
+        UnityGroup *pBest = nullptr;
+        for (auto &group : groups) {
+            if (group.files.size() < cUnityGroupFiles && !group.collides(*pSource) &&
+                (pBest == nullptr || group.bytes < pBest->bytes)) {
+                pBest = &group;
+            }
+        }
+        if (pBest == nullptr) {
+            pBest = &groups.emplace_back();
+        }
+        pBest->add(*pSource);
+    }
+
+    for (auto &group : groups) {
+        if (group.files.size() > 1) {
+            unityGroups.emplace_back(std::move(group.files));
+        }
+    }
+}
+
+} // namespace
+
+void collectInternalNames(std::string_view text, std::vector<std::string> &names) {
+    // For each open brace, whether it opened an anonymous namespace.
+    std::vector<bool> braces;
+    int parens = 0;
+    bool lineStart = true;
+    /// Set by 'static' in a statement at file scope
+    bool fileStatic = false;
+    /// Set once the current statement has given its name
+    bool declared = false;
+    /// Set by 'namespace', and whether it was given a name
+    bool inNamespace = false;
+    bool namedNamespace = false;
+    /// Set after '::', the next name is qualified
+    bool qualified = false;
+    std::string_view candidate;
+
+    auto endStatement = [&]() {
+        fileStatic = false;
+        declared = false;
+        inNamespace = false;
+        namedNamespace = false;
+    };
+    auto record = [&]() {
+        bool const internal = braces.empty() ? fileStatic : braces.back();
+        if (!candidate.empty() && !declared && parens == 0 && internal) {
+            names.emplace_back(candidate);
+            declared = true;
+        }
+        candidate = {};
+    };
+
+    std::size_t i = 0;
+    auto const size = text.size();
+    while (i < size) {
+        char const ch = text[i];
+        if (ch == '\n') {
+            lineStart = true;
+            ++i;
+            continue;
+        }
+        if (ch == ' ' || ch == '\t' || ch == '\r') {
+            ++i;
+            continue;
+        }
+
+        if (ch == '#' && lineStart) {
+            // Preprocessor lines, with their continuations.
+            while (i < size && text[i] != '\n') {
+                i += (text[i] == '\\' && i + 1 < size) ? 2 : 1;
+            }
+            continue;
+        }
+        lineStart = false;
+
+        if (ch == '/' && i + 1 < size && text[i + 1] == '/') {
+            auto const end = text.find('\n', i);
+            i = (end == std::string_view::npos) ? size : end;
+            continue;
+        }
+        if (ch == '/' && i + 1 < size && text[i + 1] == '*') {
+            auto const end = text.find("*/", i + 2);
+            i = (end == std::string_view::npos) ? size : end + 2;
+            continue;
+        }
+        if (ch == '"' || ch == '\'') {
+            for (++i; i < size && text[i] != ch && text[i] != '\n'; ++i) {
+                if (text[i] == '\\') {
+                    ++i;
+                }
+            }
+            ++i;
+            candidate = {};
+            continue;
+        }
+
+        if (isIdentifierChar(ch)) {
+            auto const start = i;
+            while (i < size && isIdentifierChar(text[i])) {
+                ++i;
+            }
+            auto const word = text.substr(start, i - start);
+            if (std::isdigit(static_cast<unsigned char>(ch))) {
+                candidate = {};
+            } else if (word == "namespace") {
+                inNamespace = true;
+                candidate = {};
+            } else if (inNamespace) {
+                namedNamespace = true;
+            } else if (word == "static" && braces.empty() && parens == 0) {
+                fileStatic = true;
+            } else if (qualified || std::find(std::begin(cNotNames), std::end(cNotNames),
+                                              word) != std::end(cNotNames)) {
+                candidate = {};
+            } else {
+                candidate = word;
+            }
+            qualified = false;
+            continue;
+        }
+
+        switch (ch) {
+        case '(':
+            record();
+            ++parens;
+            break;
+        case ')':
+            parens = std::max(0, parens - 1);
+            candidate = {};
+            break;
+        case '=':
+        case '[':
+        case ',':
+            record();
+            break;
+        case ';':
+            record();
+            if (parens == 0) {
+                endStatement();
+            }
+            break;
+        case '{':
+            if (inNamespace) {
+                braces.push_back(!namedNamespace);
+            } else {
+                record();
+                braces.push_back(false);
+            }
+            endStatement();
+            break;
+        case '}':
+            if (!braces.empty()) {
+                braces.pop_back();
+            }
+            candidate = {};
+            endStatement();
+            break;
+        case ':':
+            if (i + 1 < size && text[i + 1] == ':') {
+                qualified = true;
+                ++i;
+            } else {
+                // 'class name : base'
+                record();
+            }
+            candidate = {};
+            break;
+        default:
+            candidate = {};
+        }
+        ++i;
+    }
+}
+
+std::size_t assignUnityGroups(ProjectData &data, unsigned threadCount) {
+    // The C and C++ sources of each target, read all together.
+    struct TargetSources {
+        std::vector<std::size_t> c;
+        std::vector<std::size_t> cxx;
+    };
+    std::vector<TargetSources> targetSources(data.targets.size());
+    std::vector<std::string> paths;
+    std::vector<std::string> listed;
+    // Each source by the directory of its target, with the targets listing it.
+    std::vector<std::string> keys;
+    std::unordered_map<std::string, std::unordered_set<std::size_t>> listedBy;
+    std::error_code error;
+    for (std::size_t i = 0; i < data.targets.size(); ++i) {
+        auto const &target = data.targets[i];
+        auto directory = std::filesystem::path(target.fullPath).parent_path();
+        directory = std::filesystem::absolute(directory.empty() ? "." : directory, error);
+
+        for (auto const &[name, filter] : target.filters) {
+            for (auto const &file : filter.files) {
+                auto const lastDot = file.find_last_of('.');
+                if (isAbsolutePath(file) || lastDot == std::string::npos) {
+                    continue;
+                }
+                std::string ext = file.substr(lastDot + 1);
+                std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+
+                if (ext == "c") {
+                    targetSources[i].c.emplace_back(paths.size());
+                } else if (ext == "cpp" || ext == "cxx" || ext == "cc" || ext == "c++") {
+                    targetSources[i].cxx.emplace_back(paths.size());
+                } else {
+                    continue;
+                }
+                paths.emplace_back((directory / file).lexically_normal().string());
+                listed.emplace_back(file);
+                keys.emplace_back(directory.string() + '\n' + paths.back());
+                listedBy[keys.back()].emplace(i);
+            }
+        }
+    }
+
+    auto contents = prefetchFiles(paths, readFile, threadCount);
+    std::vector<std::size_t> sizes(paths.size(), 0);
+    std::vector<std::vector<std::string>> names(paths.size());
+    // Source properties are per directory, so a source listed by several
+    // targets of a directory can't be given a group by each of them, and is
+    // left out of the groups of all of them.
+    std::vector<bool> shared(paths.size());
+    for (std::size_t idx = 0; idx < paths.size(); ++idx) {
+        shared[idx] = listedBy[keys[idx]].size() > 1;
+    }
+
+    parallelFor(paths.size(), threadCount, [&](std::size_t idx) {
+        if (!std::get<0>(contents[idx])) {
+            return;
+        }
+        auto &text = std::get<1>(contents[idx]);
+        sizes[idx] = text.size();
+        collectInternalNames(text, names[idx]);
+        std::sort(names[idx].begin(), names[idx].end());
+        names[idx].erase(std::unique(names[idx].begin(), names[idx].end()), names[idx].end());
+        std::string().swap(text);
+    });
+
+    parallelFor(data.targets.size(), threadCount, [&](std::size_t i) {
+        auto &target = data.targets[i];
+        target.unityGroups.clear();
+        for (auto const *pSources : {&targetSources[i].c, &targetSources[i].cxx}) {
+            std::vector<UnitySource> sources;
+            for (auto idx : *pSources) {
+                if (!std::get<0>(contents[idx]) || sizes[idx] == 0 || shared[idx]) {
+                    continue;
+                }
+                auto const &file = listed[idx];
+                auto const lastSlash = file.find_last_of('/');
+                sources.push_back({file,
+                                   (lastSlash == std::string::npos) ? std::string{}
+                                                                    : file.substr(0, lastSlash),
+                                   sizes[idx], &names[idx]});
+            }
+            groupSources(std::move(sources), target.unityGroups);
+        }
+    });
+
+    std::size_t groupCount = 0;
+    for (auto const &target : data.targets) {
+        groupCount += target.unityGroups.size();
+    }
+    return groupCount;
+}
@@ -0,0 +1,67 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2018 George Cave <gcave@stablecoder.ca>
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ */
+
+#ifndef UNITY_HPP
+#define UNITY_HPP
+
+// cmkizer
+#include "type_defs.hpp"
+
+// C++
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/// The source size a unity group is aimed at.
+constexpr std::size_t cUnityGroupBytes = 512 * 1024;
+/// The most sources put in a single unity group.
+constexpr std::size_t cUnityGroupFiles = 32;
+
+/// Collects the names a source file declares with internal linkage, those
+/// within anonymous namespaces and those declared 'static' at file scope, that
+/// would collide if another such file were compiled in the same unity source.
+/// This is a quick scan of the first name declared by each statement, after
+/// skipping comments, literals and preprocessor lines, not a parse.
+/// \param text The contents of the source file.
+/// \param names Receives the declared names.
+void collectInternalNames(std::string_view text, std::vector<std::string> &names);
+
+/// Splits the C and C++ sources of each target into unity build groups,
+/// balanced by file size, rather than using CMake's fixed batch size.
+///
+/// The sources of a language are ordered by directory, so groups keep files
+/// of a directory together, then cut into runs of about equal size, each aimed
+/// at cUnityGroupBytes and at most cUnityGroupFiles sources. A source whose
+/// internal names collide with those of a source already in its group is
+/// moved to the smallest group it doesn't collide with. Unreadable sources,
+/// sources listed by more than one target of a directory, and groups left
+/// with a single source, are compiled on their own.
+/// \param data The project to process, after preprocessing.
+/// \param threadCount The number of threads to use, 0 for the hardware concurrency.
+/// \return The number of groups, over all targets.
+std::size_t assignUnityGroups(ProjectData &data, unsigned threadCount = 0);
+
+#endif // UNITY_HPP
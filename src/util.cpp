@@ -27,6 +27,7 @@
 
 // C++
 #include <algorithm>
+#include <cstdarg>
 #include <cstring>
 
 void determineLanguage(std::string fileName, TargetData &data, FilterGroup &group) {
@@ -59,6 +60,10 @@ void determineLanguage(std::string fileName, TargetData &data, FilterGroup &grou
         group.sources = true;
     }
 
+    // The files of a target share the table of its allFiles.
+    if (group.files.table() == nullptr) {
+        group.files = PathList(data.allFiles.table());
+    }
     group.files.emplace_back(fileName);
 }
 
@@ -129,4 +134,89 @@ std::vector<std::string> parseDefinitions(std::string_view definitions) noexcept
     removeDefaultDefinitions(retList);
 
     return retList;
+}
+
+bool isAbsolutePath(std::string_view path) noexcept {
+    return (!path.empty() && (path[0] == '/' || path[0] == '\\')) ||
+           path.find(':') != std::string::npos || path.find("$(") != std::string::npos;
+}
+
+std::string rebasePath(std::string_view baseDir, std::string_view path) {
+    if (path.empty() || isAbsolutePath(path)) {
+        return std::string(path);
+    }
+
+    std::vector<std::string_view> components;
+    std::size_t leadingParents = 0;
+    auto appendComponents = [&](std::string_view text) {
+        std::size_t start = 0;
+        while (start <= text.size()) {
+            auto end = std::min(text.size(), text.find('/', start));
+            std::string_view component = text.substr(start, end - start);
+
+            if (component == "..") {
+                if (components.empty()) {
+                    ++leadingParents;
+                } else {
+                    components.pop_back();
+                }
+            } else if (!component.empty() && component != ".") {
+                components.emplace_back(component);
+            }
+            start = end + 1;
+        }
+    };
+    appendComponents(baseDir);
+    appendComponents(path);
+
+    std::string retVal;
+    for (std::size_t i = 0; i < leadingParents; ++i) {
+        retVal += "../";
+    }
+    for (auto component : components) {
+        retVal += component;
+        retVal += '/';
+    }
+    if (retVal.empty()) {
+        return ".";
+    }
+    retVal.pop_back();
+
+    return retVal;
+}
+
+void appendf(std::string &out, char const *format, ...) {
+    va_list args;
+    va_start(args, format);
+    va_list argsCopy;
+    va_copy(argsCopy, args);
+    int const length = vsnprintf(nullptr, 0, format, argsCopy);
+    va_end(argsCopy);
+
+    if (length > 0) {
+        auto const start = out.size();
+        out.resize(start + length + 1);
+        vsnprintf(&out[start], length + 1, format, args);
+        out.resize(start + length);
+    }
+    va_end(args);
+}
+
+std::tuple<bool, std::string> readFile(std::string const &path) {
+    std::string contents;
+
+    FILE *pIn = fopen(path.c_str(), "rb");
+    if (pIn == nullptr) {
+        return std::make_tuple(false, std::move(contents));
+    }
+
+    char buffer[65536];
+    std::size_t bytesRead;
+    while ((bytesRead = fread(buffer, 1, sizeof(buffer), pIn)) > 0) {
+        contents.append(buffer, bytesRead);
+    }
+    bool const success = ferror(pIn) == 0;
+    fclose(pIn);
+
+    return std::make_tuple(success, std::move(contents));
 }
\ No newline at end of file
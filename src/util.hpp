@@ -32,6 +32,7 @@
 // C++
 #include <cstdio>
 #include <string>
+#include <tuple>
 #include <vector>
 
 /// Determines, using the file's extension whether the file is a header, source,
@@ -66,4 +67,30 @@ void removeDefaultIncludes(std::vector<std::string> &includeList);
 
 std::vector<std::string> parseDefinitions(std::string_view definitions) noexcept;
 
+/// Reads the entire contents of a file.
+/// \param path The path of the file to read.
+/// \return True and the file's contents if it could be read.
+std::tuple<bool, std::string> readFile(std::string const &path);
+
+/// Appends printf-style formatted text to a string.
+/// \param out The string to append to.
+/// \param format The printf format string.
+void appendf(std::string &out, char const *format, ...)
+#if defined(__GNUC__)
+    __attribute__((format(printf, 2, 3)))
+#endif
+    ;
+
+/// Determines if a path is absolute, or otherwise anchored by an MSVS macro.
+/// \param path The path to check.
+/// \return True if the path is not relative.
+bool isAbsolutePath(std::string_view path) noexcept;
+
+/// Joins a relative path onto a base directory, collapsing any '.' and '..'
+/// components. Absolute paths and those using MSVS macros are returned as-is.
+/// \param baseDir The directory the path is relative to, may be empty.
+/// \param path The path to rebase.
+/// \return The path relative to the base directory's own root.
+std::string rebasePath(std::string_view baseDir, std::string_view path);
+
 #endif // UTIL_HPP
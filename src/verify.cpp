@@ -0,0 +1,181 @@
+/*
+ *  MIT License
+ *
+ *  Copyright (c) 2018 George Cave <gcave@stablecoder.ca>
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ */
+
+#include "verify.hpp"
+
+// cmkizer
+#include "parallel.hpp"
+
+// C++
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace {
+
+/// The entries of a single directory.
+struct DirectoryListing {
+    std::string path;
+    bool exists{false};
+    std::unordered_set<std::string> names;
+    /// Lower-cased names, to point out files that only differ in case
+    std::unordered_set<std::string> foldedNames;
+};
+
+/// A listed file, split into the directory to look in and its name there.
+struct FileCheck {
+    std::size_t directory;
+    std::string name;
+};
+
+std::string foldCase(std::string str) {
+    std::transform(str.begin(), str.end(), str.begin(), ::tolower);
+    return str;
+}
+
+/// \return The normalized path of a listed file, or an empty string if it
+/// cannot be checked.
+std::string resolvePath(std::string const &baseDir, std::string const &file) {
+    if (file.empty() || file.find("$(") != std::string::npos ||
+        file.find(':') != std::string::npos) {
+        return {};
+    }
+    return (std::filesystem::path(baseDir) / file).lexically_normal().generic_string();
+}
+
+std::string targetFileDirectory(TargetData const &target) {
+    auto const lastSlash = target.fullPath.find_last_of("/\\");
+    if (lastSlash == std::string::npos) {
+        return ".";
+    }
+    std::string dir = target.fullPath.substr(0, lastSlash);
+    std::replace(dir.begin(), dir.end(), '\\', '/');
+    return dir.empty() ? "/" : dir;
+}
+
+} // namespace
+
+std::size_t verifySources(ProjectData &data, bool dropMissing, unsigned threadCount) {
+    std::vector<DirectoryListing> directories;
+    std::unordered_map<std::string, std::size_t> directoryIndices;
+
+    // Every unique file path, and the directory it is to be found in.
+    std::unordered_map<std::string, FileCheck> checks;
+
+    auto addFile = [&](std::string const &baseDir, std::string const &file) {
+        std::string path = resolvePath(baseDir, file);
+        if (path.empty()) {
+            return;
+        }
+        if (checks.count(path) != 0) {
+            return;
+        }
+
+        auto const lastSlash = path.find_last_of('/');
+        std::string dir = (lastSlash == std::string::npos) ? "." : path.substr(0, lastSlash);
+        if (dir.empty()) {
+            dir = "/";
+        }
+        auto [it, inserted] = directoryIndices.try_emplace(dir, directories.size());
+        if (inserted) {
+            directories.emplace_back().path = dir;
+        }
+        checks.try_emplace(path, FileCheck{it->second, path.substr(lastSlash + 1)});
+    };
+
+    for (auto const &target : data.targets) {
+        std::string baseDir = targetFileDirectory(target);
+        for (auto const &file : target.allFiles) {
+            addFile(baseDir, file);
+        }
+        for (auto const &[name, filter] : target.filters) {
+            for (auto const &file : filter.files) {
+                addFile(baseDir, file);
+            }
+        }
+    }
+
+    parallelFor(directories.size(), threadCount, [&](std::size_t idx) {
+        auto &listing = directories[idx];
+
+        std::error_code error;
+        std::filesystem::directory_iterator it(listing.path, error);
+        listing.exists = !error;
+        for (std::filesystem::directory_iterator end; !error && it != end; it.increment(error)) {
+            std::string name = it->path().filename().string();
+            listing.foldedNames.emplace(foldCase(name));
+            listing.names.emplace(std::move(name));
+        }
+    });
+
+    std::size_t missingCount = 0;
+    auto isMissing = [&](std::string const &baseDir, std::string const &file,
+                         TargetData const &target) {
+        std::string path = resolvePath(baseDir, file);
+        if (path.empty()) {
+            return false;
+        }
+        auto const &check = checks.at(path);
+        auto const &listing = directories[check.directory];
+        if (listing.names.count(check.name) != 0) {
+            return false;
+        }
+
+        ++missingCount;
+        std::string message = "Warning: Missing source file in " + target.name + " - " + file;
+        if (listing.foldedNames.count(foldCase(check.name)) != 0) {
+            message += " (differs in case from the file on disk)";
+        }
+        data.diagnostics.emplace_back(std::move(message));
+        return true;
+    };
+
+    for (auto &target : data.targets) {
+        std::string baseDir = targetFileDirectory(target);
+        auto checkFiles = [&](PathList &files) {
+            if (dropMissing) {
+                files.removeIf([&](PathList::Entry const &entry) {
+                    return isMissing(baseDir, files.path(entry), target);
+                });
+            } else {
+                for (auto const &file : files) {
+                    isMissing(baseDir, file, target);
+                }
+            }
+        };
+
+        checkFiles(target.allFiles);
+        for (auto &[name, filter] : target.filters) {
+            checkFiles(filter.files);
+        }
+    }
+
+    return missingCount;
+}
@@ -61,7 +61,7 @@ void parseConfigurationNode(xmlNode const *configNode, TargetData &data) noexcep
 
         for (xmlNode *toolNode = configNode->children; toolNode != nullptr;
              toolNode = toolNode->next) {
-            parseToolNode(toolNode, data.configs[{confName.begin(), confName.end()}]);
+            parseToolNode(toolNode, data.configs[{confName.begin(), confName.end()}].edit());
         }
     }
 }
@@ -91,12 +91,16 @@ void parseFilterNode(xmlNode const *filterNode, TargetData &data) noexcept {
     }
 }
 
-std::tuple<bool, TargetData> vfprojTargetParse(std::string_view targetPath) noexcept {
+std::tuple<bool, TargetData> vfprojTargetParse(std::string_view targetPath,
+                                               std::string_view contents,
+                                               std::shared_ptr<PathTable> pathTable) noexcept {
     TargetData data;
     data.enableFortran = true;
     data.fullPath = targetPath;
+    data.allFiles = PathList(std::move(pathTable));
 
-    xmlDoc *document = xmlReadFile(targetPath.data(), nullptr, 0);
+    xmlDoc *document =
+        xmlReadMemory(contents.data(), static_cast<int>(contents.size()), nullptr, nullptr, 0);
     if (document == nullptr) {
         return std::make_tuple(false, data);
     }
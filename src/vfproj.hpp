@@ -28,13 +28,18 @@
 
 #include "type_defs.hpp"
 
+#include <memory>
 #include <string>
 #include <tuple>
 
 /** @brief Parses a vfproj target file, typically for intel Fortran plugins to Visual Studio
  * @param targetPath The path representing the file to parse
+ * @param contents The contents of the file
+ * @param pathTable Receives the directories of the target's files
  * @return A boolean representing th parse success, and the associated parsed TargetData
  */
-std::tuple<bool, TargetData> vfprojTargetParse(std::string_view targetPath) noexcept;
+std::tuple<bool, TargetData> vfprojTargetParse(std::string_view targetPath,
+                                               std::string_view contents,
+                                               std::shared_ptr<PathTable> pathTable) noexcept;
 
 #endif // VFPROJ_HPP
\ No newline at end of file
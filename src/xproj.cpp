@@ -28,20 +28,43 @@
 #include <libxml/parser.h>
 
 #include <algorithm>
+#include <future>
 #include <map>
 #include <string>
 
+#include "condition.hpp"
 #include "util.hpp"
 
-void parseFilter(xmlNode *itemNode, TargetData &data) noexcept {
+/// Returns the given property of a node, or an empty string if it is not present.
+std::string getProp(xmlNode const *node, char const *name) {
+    std::string retVal;
+    xmlChar *prop = xmlGetProp(node, (const xmlChar *)name);
+    if (prop != nullptr) {
+        retVal = (char const *)prop;
+        xmlFree(prop);
+    }
+    return retVal;
+}
+
+/// Returns the text content of a node, or an empty string if it has none.
+std::string getContent(xmlNode const *node) {
+    if (node->children == nullptr || node->children->content == nullptr) {
+        return {};
+    }
+    return (char const *)node->children->content;
+}
+
+/// Maps each item's Include path to the name of the filter it belongs to.
+using FilterMap = std::map<std::string, std::string>;
 
-    std::string_view includeProp = (const char *)xmlGetProp(itemNode, (const xmlChar *)"Include");
+void parseFilter(xmlNode *itemNode, FilterMap &filterMap) {
+    std::string includeProp = getProp(itemNode, "Include");
 
     for (xmlNode *filterNode = itemNode->children; filterNode != nullptr;
          filterNode = filterNode->next) {
         std::string_view nodeName = (char const *)filterNode->name;
 
-        if (nodeName == "Filter") {
+        if (nodeName == "Filter" && filterNode->children != nullptr) {
             std::string filterName = (char const *)filterNode->children->content;
 
             for (auto it = filterName.begin(); it != filterName.end(); ++it) {
@@ -51,23 +74,25 @@ void parseFilter(xmlNode *itemNode, TargetData &data) noexcept {
                 }
             }
 
-            determineLanguage({includeProp.begin(), includeProp.end()}, data,
-                              data.filters[filterName]);
+            filterMap[includeProp] = std::move(filterName);
         }
     }
 }
 
-void parseFiltersFile(std::string_view path, TargetData &data) noexcept {
-    std::string filtersFilePath = path.data();
-    filtersFilePath += ".filters";
+/// Reads the '.filters' file accompanying a vcxproj, mapping items to their filters.
+/// \param contents The contents of the '.filters' file.
+FilterMap parseFiltersFile(std::string contents) {
+    FilterMap filterMap;
 
-    xmlDoc *document = xmlReadFile(filtersFilePath.data(), nullptr, 0);
+    xmlDoc *document =
+        xmlReadMemory(contents.data(), static_cast<int>(contents.size()), nullptr, nullptr, 0);
     if (document == nullptr)
-        return;
+        return filterMap;
 
     xmlNode *rootNode = xmlDocGetRootElement(document);
     if (rootNode == nullptr) {
-        return;
+        xmlFreeDoc(document);
+        return filterMap;
     }
 
     for (xmlNode *groupNode = rootNode->children; groupNode != nullptr;
@@ -81,11 +106,14 @@ void parseFiltersFile(std::string_view path, TargetData &data) noexcept {
 
                 if (nodeName == "ClCompile" || nodeName == "ClInclude" ||
                     nodeName == "ResourceCompile") {
-                    parseFilter(filterNode, data);
+                    parseFilter(filterNode, filterMap);
                 }
             }
         }
     }
+
+    xmlFreeDoc(document);
+    return filterMap;
 }
 
 void parseProjectConfigurations(xmlNode *node, TargetData &data) noexcept {
@@ -93,15 +121,36 @@ void parseProjectConfigurations(xmlNode *node, TargetData &data) noexcept {
         std::string_view nodeName = (char const *)childNode->name;
 
         if (nodeName == "ProjectConfiguration") {
-            std::string includeProp =
-                (char const *)xmlGetProp(childNode, (const xmlChar *)"Include");
+            data.configs[getProp(childNode, "Include")];
+        }
+    }
+}
 
-            data.configs[includeProp];
+/// Builds the condition cache for the target's configurations, where each
+/// 'Configuration|Platform' name provides the matching MSBuild properties.
+ConditionCache buildConditionCache(TargetData const &data) {
+    std::vector<std::string> configNames;
+    std::vector<PropertyMap> configProperties;
+
+    for (auto const &[name, config] : data.configs) {
+        PropertyMap properties;
+        auto split = name.find('|');
+        properties["Configuration"] = name.substr(0, split);
+        if (split != std::string::npos) {
+            properties["Platform"] = name.substr(split + 1);
         }
+
+        configNames.emplace_back(name);
+        configProperties.emplace_back(std::move(properties));
     }
+
+    return ConditionCache(std::move(configNames), std::move(configProperties));
 }
 
 void parseClCompile(xmlNode *node, TargetConfig &config) noexcept {
+    std::string pchMode;
+    std::string pchFile;
+
     for (xmlNode *childNode = node->children; childNode != nullptr; childNode = childNode->next) {
         std::string_view childName = (char const *)childNode->name;
 
@@ -111,8 +160,37 @@ void parseClCompile(xmlNode *node, TargetConfig &config) noexcept {
             if (!defs.empty()) {
                 config.definitions = defs;
             }
+        } else if (childName == "AdditionalIncludeDirectories") {
+            auto dirs = parseDefinitions(getContent(childNode));
+
+            if (!dirs.empty()) {
+                config.includeDirs = dirs;
+            }
+        } else if (childName == "PrecompiledHeader") {
+            pchMode = getContent(childNode);
+        } else if (childName == "PrecompiledHeaderFile") {
+            pchFile = getContent(childNode);
+        } else if (childName == "MultiProcessorCompilation") {
+            config.multiProcessorCompilation = getContent(childNode) == "true";
+        } else if (childName == "WholeProgramOptimization") {
+            config.wholeProgramOptimization = getContent(childNode) == "true";
+        } else if (childName == "Optimization") {
+            config.optimization = getContent(childNode);
+        } else if (childName == "IntrinsicFunctions") {
+            config.intrinsicFunctions = getContent(childNode) == "true";
+        } else if (childName == "EnableEnhancedInstructionSet") {
+            config.enhancedInstructionSet = getContent(childNode);
+        } else if (childName == "FunctionLevelLinking") {
+            config.functionLevelLinking = getContent(childNode) == "true";
         }
     }
+
+    if (pchMode == "Use") {
+        // MSBuild defaults to stdafx.h when no header is given.
+        config.precompiledHeader = pchFile.empty() ? "stdafx.h" : pchFile;
+    } else if (!pchMode.empty()) {
+        config.precompiledHeader.clear();
+    }
 }
 
 void parseLink(xmlNode *node, TargetConfig &config) noexcept {
@@ -135,37 +213,51 @@ void parseLink(xmlNode *node, TargetConfig &config) noexcept {
     }
 }
 
-void parseItemDefinitionGroup(xmlNode *node, TargetData &data) noexcept {
-    std::string conditionProp = (char const *)xmlGetProp(node, (const xmlChar *)"Condition");
+void parseItemDefinitionGroup(xmlNode *node, TargetData &data, ConditionCache &conditions) {
+    auto const &matches = conditions.evaluate(getProp(node, "Condition"));
 
+    std::size_t configIdx = 0;
     for (auto &[name, config] : data.configs) {
-        if (conditionProp.find(name) != std::string::npos) {
+        if (matches[configIdx++]) {
             for (xmlNode *childNode = node->children; childNode != nullptr;
                  childNode = childNode->next) {
                 std::string_view childName = (char const *)childNode->name;
 
                 if (childName == "ClCompile") {
-                    parseClCompile(childNode, config);
+                    parseClCompile(childNode, config.edit());
                 } else if (childName == "Link") {
-                    parseLink(childNode, config);
+                    parseLink(childNode, config.edit());
                 }
             }
         }
     }
 }
 
-std::tuple<bool, TargetData> xprojTargetParse(std::string_view targetPath) {
+std::tuple<bool, TargetData> xprojTargetParse(std::string_view targetPath,
+                                              std::string_view contents,
+                                              FileReader const &readFile,
+                                              std::shared_ptr<PathTable> pathTable) {
     TargetData data;
     data.fullPath = targetPath;
+    data.allFiles = PathList(std::move(pathTable));
+
+    // The filters file is parsed alongside the project file, the two are joined
+    // once the project's items are known.
+    std::future<FilterMap> filtersTask;
+    if (auto [found, filtersContents] = readFile(std::string(targetPath) + ".filters"); found) {
+        xmlInitParser();
+        filtersTask =
+            std::async(std::launch::async, parseFiltersFile, std::move(filtersContents));
+    }
 
-    parseFiltersFile(targetPath, data);
-
-    xmlDoc *document = xmlReadFile(targetPath.data(), nullptr, 0);
+    xmlDoc *document =
+        xmlReadMemory(contents.data(), static_cast<int>(contents.size()), nullptr, nullptr, 0);
     if (document == nullptr) {
         return std::make_tuple(false, data);
     }
     xmlNode *rootNode = xmlDocGetRootElement(document);
     if (rootNode == nullptr) {
+        xmlFreeDoc(document);
         return std::make_tuple(false, data);
     }
 
@@ -178,17 +270,29 @@ std::tuple<bool, TargetData> xprojTargetParse(std::string_view targetPath) {
     auto end = targetPath.find_last_of('.');
     data.name = targetPath.substr(start, end - start);
 
+    // The configurations are needed up-front to evaluate the conditions of
+    // other groups.
+    for (xmlNode *rootChild = rootNode->children; rootChild != nullptr;
+         rootChild = rootChild->next) {
+        if (std::string_view((const char *)rootChild->name) == "ItemGroup" &&
+            getProp(rootChild, "Label") == "ProjectConfigurations") {
+            parseProjectConfigurations(rootChild, data);
+        }
+    }
+    ConditionCache conditions = buildConditionCache(data);
+
+    // Source/header items, in project order
+    std::vector<std::string> items;
+
     for (xmlNode *rootChild = rootNode->children; rootChild != rootNode->last;
          rootChild = rootChild->next) {
         std::string_view childName = (const char *)rootChild->name;
 
         if (childName == "ItemGroup") {
-            std::string_view itemGroupLabel =
-                (const char *)xmlGetProp(rootChild, (const xmlChar *)"Label");
+            std::string itemGroupLabel = getProp(rootChild, "Label");
 
             if (itemGroupLabel == "ProjectConfigurations") {
-                parseProjectConfigurations(rootChild, data);
-
+                // Already parsed.
             } else {
                 // File/Project Reference Group
 
@@ -210,17 +314,16 @@ std::tuple<bool, TargetData> xprojTargetParse(std::string_view targetPath) {
                         }
                     } else {
                         // It's a source/header file
-                        std::string_view includeName =
-                            (const char *)xmlGetProp(fileNode, (const xmlChar *)"Include");
+                        std::string includeName = getProp(fileNode, "Include");
 
                         if (!includeName.empty())
-                            data.allFiles.emplace_back(includeName);
+                            items.emplace_back(std::move(includeName));
                     }
                 }
             }
 
         } else if (childName == "PropertyGroup") {
-            std::string_view temp = (const char *)xmlGetProp(rootChild, (const xmlChar *)"Label");
+            std::string temp = getProp(rootChild, "Label");
             // Property Group - Globals
             if (temp == "Globals") {
                 for (xmlNode *propGroup = rootNode->children; propGroup != rootNode->last;
@@ -231,10 +334,11 @@ std::tuple<bool, TargetData> xprojTargetParse(std::string_view targetPath) {
                     }
                 }
             } else if (temp == "Configuration") {
-                std::string_view condition =
-                    (const char *)xmlGetProp(rootChild, (const xmlChar *)"Condition");
+                auto const &matches = conditions.evaluate(getProp(rootChild, "Condition"));
+
+                std::size_t configIdx = 0;
                 for (auto &[name, config] : data.configs) {
-                    if (condition.find(name) != std::string::npos) {
+                    if (matches[configIdx++]) {
                         for (xmlNode *configNode = rootChild->children;
                              configNode != rootChild->last; configNode = configNode->next) {
                             std::string_view nodeName = (const char *)configNode->name;
@@ -245,15 +349,33 @@ std::tuple<bool, TargetData> xprojTargetParse(std::string_view targetPath) {
                                 if (content.find("Library") != std::string::npos) {
                                     data.isLibrary = true;
                                 }
+                            } else if (nodeName == "WholeProgramOptimization") {
+                                config.edit().wholeProgramOptimization =
+                                    getContent(configNode) == "true";
                             }
                         }
                     }
                 }
             }
         } else if (childName == "ItemDefinitionGroup") {
-            parseItemDefinitionGroup(rootChild, data);
+            parseItemDefinitionGroup(rootChild, data, conditions);
+        }
+    }
+
+    // Each item is classified once, into its filter if it has one.
+    FilterMap filterMap = filtersTask.valid() ? filtersTask.get() : FilterMap{};
+    FilterGroup unfiltered;
+    unfiltered.files = PathList(data.allFiles.table());
+    for (auto &item : items) {
+        auto it = filterMap.find(item);
+        if (it != filterMap.end()) {
+            determineLanguage(std::move(item), data, data.filters[it->second]);
+        } else {
+            determineLanguage(std::move(item), data, unfiltered);
         }
     }
+    data.allFiles = std::move(unfiltered.files);
 
+    xmlFreeDoc(document);
     return std::make_tuple(true, data);
 }
\ No newline at end of file
@@ -30,13 +30,20 @@
 #include "type_defs.hpp"
 
 // C++
+#include <memory>
 #include <string>
 #include <tuple>
 
 /// Parses a vcxproj target file.
 /// \param targetPath The path of the file to parse.
+/// \param contents The contents of the file.
+/// \param readFile Provides the accompanying '.filters' file.
+/// \param pathTable Receives the directories of the target's files.
 /// \return A boolean representing the parse success, and the associated parsed
 /// TargetData.
-std::tuple<bool, TargetData> xprojTargetParse(std::string_view targetPath);
+std::tuple<bool, TargetData> xprojTargetParse(std::string_view targetPath,
+                                              std::string_view contents,
+                                              FileReader const &readFile,
+                                              std::shared_ptr<PathTable> pathTable);
 
 #endif // XPROJ_HPP